@@ -1,26 +1,103 @@
 #include "boot.h"
 #include "boot_cmd.h"
+#include "boot_combine.h"
+#include "boot_event.h"
+#include "boot_image.h"
+#include "boot_resume.h"
+#include "boot_slot.h"
+#include "boot_task.h"
+#include "boot_transport.h"
 #include "key_driver.h"
 #include "led_driver.h"
+#include <stddef.h>
 #include <string.h>
 
 extern KEY_Device_t K1;
 extern LED_Device_t LED;
 
-static BootState_t current_boot_state = BOOT_STATE_WAIT;
-static parse_result_t command_parse_result;
-static command_frame_t current_frame;
+static volatile BootState_t current_boot_state = BOOT_STATE_WAIT;
 static BOOT_FirmwareInfo_t firmwareInfo;
-static volatile bool is_recived = false;
-static volatile BootErrorCode_t bootErrorCode = ERROR_CODE_NO_ERROR;
-static volatile bool is_run_app = false;
+// 中断只投递事件，以下状态都只在主循环中读写
+static BootErrorCode_t bootErrorCode = ERROR_CODE_NO_ERROR;
+static bool is_run_app = false;
+// 启动等待超时事件只投递一次
+static volatile bool wait_timeout_posted = false;
+// 本次升级的固件长度，全部写完后在CMD_VERIFY时切换槽；
+// 按包上传时已写入的包记录在续传进度中
+static uint32_t upload_length = 0;
+#if !BOOT_RESUME_PERSIST
+static BootResumeState_t resume_ram;
+#endif
+// 最近写入的包号和数据CRC，循环覆盖，用于识别ACK丢失后重发的包
+#define BOOT_UPLOAD_HISTORY_NONE 0xFFFFFFFFU
+static struct {
+    uint32_t packetNum;
+    uint32_t crc32;
+} upload_history[BOOT_UPLOAD_HISTORY_NUMS];
+static uint8_t upload_history_pos = 0;
+// 按地址上传的会话已开始，即候选槽已作废，之后的记录不再作废
+static bool record_session = false;
+
+// upload任务本次的擦写
+#define BOOT_UPLOAD_ERASE_NONE 0  // 不擦除，直接写入
+#define BOOT_UPLOAD_ERASE_SLOT 1  // 作废候选槽并擦除前slotLength字节（第一包）
+#define BOOT_UPLOAD_ERASE_RANGE 2 // 只擦除本条记录覆盖的块（按地址上传）
+static struct {
+    uint8_t erase;       // BOOT_UPLOAD_ERASE_xxx
+    uint32_t slotLength; // 整槽擦除的长度
+    uint32_t offset;     // 槽内偏移
+    uint32_t length;     // 写入或擦除的长度
+    const uint8_t *data; // 写入的数据，NULL为只擦除
+    uint32_t crc32;      // 按包上传时数据的CRC32，写入后记入upload_history
+} upload_op;
+// 上传数据的写合并缓冲，不足一个闪存字的数据在这里凑满再写
+static BootCombine_t write_combine = {BOOT_COMBINE_NONE, 0, {0}};
+
+// 协作式任务：轮询传输通道、LED指示、固件擦写、整镜像校验和按块计算CRC
+static BootTask_t rx_task;
+static BootTask_t led_task;
+static BootTask_t upload_task;
+static BootTask_t verify_task;
+static BootTask_t block_crc_task;
+static BootSlotJob_t slot_job;
+static BootImageVerifyJob_t verify_job;
+// CMD_BLOCK_CRC的应答，由block_crc_task逐块填写
+static BOOT_BlockCrcInfo_t block_crc;
+static uint32_t block_crc_nums = 0; // 本次要计算的块数
+// 擦写或校验期间收到的普通命令帧暂存在帧槽中，任务结束后再处理
+#define BOOT_DEFERRED_NONE 0xFF
+static uint8_t deferred_slot = BOOT_DEFERRED_NONE;
+// 最近一轮调度中是否有任务主动让出
+static bool task_yielded = false;
+// CMD_STATUS上报的累计统计，其余字段在应答时填写
+static statusInfo_t boot_status;
+static uint32_t operation_start_us = 0;
 
 // 发送函数指针
 Boot_SendData_Func boot_send_func = NULL;
 
+// 已注册的传输通道，以及建立会话的通道
+static BootTransport_t *transports[BOOT_TRANSPORT_MAX_NUMS];
+static uint8_t transport_nums = 0;
+// 会话通道只由主循环写入，中断只读它来丢弃其他通道的帧
+static BootTransport_t *volatile active_transport = NULL;
+// 帧槽中的帧来自哪个通道，中断在投递帧事件前写入，主循环取出事件后读取
+static BootTransport_t *frame_transport[BOOT_FRAME_SLOT_NUMS];
+// 本次会话协商的固件包大小和帧校验方式，只在主循环中读写
+static uint16_t firmware_packet_size = DEVICE_INFO_FIRMWARE_PACKET_SIZE;
+static frame_check_t frame_check = FRAME_CHECK_SUM8;
+// Boot_Init传入的发送函数包装成的通道，Boot_ReceiveCommand的数据也进入此通道
+static BootTransport_t legacy_transport;
+static uint8_t legacy_rx_buffer[COMMAND_PARSER_BUFFER_SIZE(FRAME_DATA_SIZE)];
+
 // Boot初始化状态
 static bool boot_initialized = false;
 
+// 跳转前的外设反初始化函数表
+static Boot_DeInit_Func deinit_funcs[BOOT_DEINIT_MAX_NUMS];
+static uint8_t deinit_nums = 0;
+static uint32_t boot_handoff = BOOT_HANDOFF_DEFAULT;
+
 // 错误信息
 const char *ErrorMessage[ERROR_CODE_NUMS] = {
     "No error",
@@ -34,14 +111,58 @@ const char *ErrorMessage[ERROR_CODE_NUMS] = {
 };
 
 // 静态函数声明
-static void Boot_ProcessReceivedCommand(void);
+static void Boot_ProcessReceivedCommand(command_frame_t *frame);
 static bool Boot_SendFrame(command_type_t cmd, uint8_t *data,
                            uint16_t data_len);
 static void Boot_SendAckResponse(void);
 static void Boot_SendEnterBootResponse(void);
 static void Boot_SendErrorResponse(BootErrorCode_t errorCode);
+static void Boot_SendStatusResponse(void);
 static BootErrorCode_t Boot_ProcessUploadCommand(command_frame_t *frame);
-static BootErrorCode_t Boot_FlashProgram();
+static BootErrorCode_t Boot_ProcessRecordCommand(command_frame_t *frame);
+static bool Boot_IsRepeatedPacket(uint32_t packet_num, uint32_t packet_total,
+                                  const uint8_t *data, uint32_t length,
+                                  uint32_t crc, BootErrorCode_t *err);
+static void Boot_ClearUploadHistory(void);
+static BootErrorCode_t Boot_CombineFlush(BootSlot_t slot);
+static BootErrorCode_t Boot_UploadWriteBegin(BootSlot_t slot, bool *writing);
+static BootErrorCode_t Boot_ProcessVerifyCommand(void);
+static BootErrorCode_t Boot_ProcessBlockCRCCommand(command_frame_t *frame);
+static void Boot_ProcessAbortCommand(void);
+static BootTaskStatus_t Boot_RxTask(BootTask_t *task);
+static BootTaskStatus_t Boot_LedTask(BootTask_t *task);
+static BootTaskStatus_t Boot_UploadTask(BootTask_t *task);
+static BootTaskStatus_t Boot_VerifyTask(BootTask_t *task);
+static BootTaskStatus_t Boot_BlockCRCTask(BootTask_t *task);
+static void Boot_SendString(const char *str, uint16_t length);
+static char *Boot_AppendString(char *p, const char *str);
+static char *Boot_AppendU32(char *p, uint32_t value);
+static void Boot_PollTransports(void);
+static void Boot_FlushTransports(void);
+static void Boot_SetTransportBusy(BootTransport_t *transport, bool busy);
+static bool Boot_ClaimSession(uint8_t slot);
+static void Boot_PostFrame(BootTransport_t *transport);
+static uint8_t *Boot_TxBufAllocWait(uint16_t size);
+static bool Boot_TransportSend(BootTransport_t *transport, uint8_t *buffer,
+                               uint16_t length);
+static void Boot_TransportSendCopy(BootTransport_t *transport,
+                                   const uint8_t *data, uint16_t length);
+
+// 兼容通道：发送走boot_send_func
+static bool Boot_LegacyTx(BootTransport_t *transport, const uint8_t *data,
+                          uint16_t length) {
+    (void)transport;
+    return boot_send_func != NULL && boot_send_func((uint8_t *)data, length);
+}
+static uint16_t Boot_LegacyMaxPacket(BootTransport_t *transport) {
+    (void)transport;
+    return FRAME_SIZE;
+}
+static const BootTransportOps_t legacy_transport_ops = {
+    .tx = Boot_LegacyTx,
+    .max_packet = Boot_LegacyMaxPacket,
+};
+
 const char *GetErrorMessage(BootErrorCode_t errorCode) {
     if (errorCode >= ERROR_CODE_NUMS) {
         return "Unknown error code";
@@ -54,17 +175,53 @@ void Boot_Init(Boot_SendData_Func send_func) {
         return; // 避免重复初始化
     }
 
-    // 初始化命令解析器
-    command_parser_init();
+    active_transport = NULL;
+    firmware_packet_size = DEVICE_INFO_FIRMWARE_PACKET_SIZE;
+    frame_check = FRAME_CHECK_SUM8;
+    // 加载A/B槽元数据
+    Boot_SlotInit();
+    // 恢复上传进度，备份SRAM在Boot_SlotInit中使能
+#if BOOT_RESUME_PERSIST
+    Boot_ResumeInit((BootResumeState_t *)BOOT_RESUME_RAM_ADDRESS);
+#else
+    Boot_ResumeInit(&resume_ram);
+#endif
+    Boot_ClearUploadHistory();
+    // 使能DWT周期计数器，用于校验等耗时统计
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 
-    // 设置发送函数
+    // 设置发送函数，Boot_ReceiveCommand的数据始终进入兼容通道
     boot_send_func = send_func;
+    legacy_transport.name = "default";
+    legacy_transport.ops = &legacy_transport_ops;
+    legacy_transport.context = NULL;
+    legacy_transport.rx_buffer = legacy_rx_buffer;
+    legacy_transport.rx_buffer_size = sizeof(legacy_rx_buffer);
+    command_parser_setup(&legacy_transport.parser, legacy_rx_buffer,
+                         sizeof(legacy_rx_buffer));
+    if (send_func != NULL) {
+        Boot_RegisterTransport(&legacy_transport);
+    }
 
     // 初始化状态机
     current_boot_state = BOOT_STATE_WAIT;
-    is_recived = false;
     bootErrorCode = ERROR_CODE_NO_ERROR;
     is_run_app = false;
+    wait_timeout_posted = false;
+    Boot_EventReset();
+    deferred_slot = BOOT_DEFERRED_NONE;
+    task_yielded = false;
+    memset(&boot_status, 0, sizeof(statusInfo_t));
+    Boot_TaskInit(&rx_task, "rx", Boot_RxTask);
+    Boot_TaskInit(&led_task, "led", Boot_LedTask);
+    Boot_TaskInit(&upload_task, "upload", Boot_UploadTask);
+    Boot_TaskInit(&verify_task, "verify", Boot_VerifyTask);
+    Boot_TaskInit(&block_crc_task, "block_crc", Boot_BlockCRCTask);
+    Boot_TaskStart(&rx_task);
+    Boot_TaskStart(&led_task);
     boot_initialized = true;
 }
 
@@ -73,35 +230,81 @@ void Boot_ProcessStateMachine(void) {
     if (!boot_initialized) {
         return;
     }
+    // 每轮先调度一次所有任务，擦写和校验分步执行，不会阻塞命令处理
+    task_yielded = Boot_TaskRunAll();
+    if (Boot_IsFlashBusy()) {
+        boot_status.operationUs = Boot_GetUs() - operation_start_us;
+    }
+    // 每次只处理一个事件，队列不空时Boot_IsIdle返回false，主循环不会睡眠
+    // 跳转状态不取事件，跳转失败回到Bootloader模式后再处理
+    BootEvent_t event = {.type = BOOT_EVENT_NONE};
+    if (current_boot_state != BOOT_STATE_APPLICATION_JUMP &&
+        Boot_EventGet(&event) && event.type == BOOT_EVENT_FRAME &&
+        !Boot_ClaimSession(event.arg)) {
+        event.type = BOOT_EVENT_NONE;
+    }
+    // 队列空闲且擦写校验已结束时，处理暂存的命令帧
+    if (event.type == BOOT_EVENT_NONE && deferred_slot != BOOT_DEFERRED_NONE &&
+        !Boot_IsFlashBusy()) {
+        event.type = BOOT_EVENT_FRAME;
+        event.arg = deferred_slot;
+        deferred_slot = BOOT_DEFERRED_NONE;
+    }
     switch (current_boot_state) {
     case BOOT_STATE_WAIT:
-        if (HAL_GetTick() > BOOT_WAIT_TIME_MS) {
+        if (event.type == BOOT_EVENT_TIMEOUT) {
             current_boot_state = BOOT_STATE_APPLICATION_JUMP;
-        } else if (KEY_GetState(&K1) == KEY_State_DOWN) {
+        } else if (event.type == BOOT_EVENT_KEY &&
+                   event.arg == KEY_State_DOWN) {
             current_boot_state = BOOT_STATE_BOOTLOADER;
             const char enter_boot_str[] = "Enter BootLoader Mode\n";
-            boot_send_func((uint8_t *)enter_boot_str, strlen(enter_boot_str));
+            Boot_SendString(enter_boot_str, strlen(enter_boot_str));
+        } else if (event.type == BOOT_EVENT_FRAME) {
+            // 还没进入Bootloader模式，丢弃命令帧
+            Boot_FrameRelease(event.arg);
+            Boot_SetTransportBusy(active_transport, false);
         }
         break;
 
     case BOOT_STATE_BOOTLOADER:
-        BootState_t bootloader_result = Boot_EnterBootloaderMode();
+        BootState_t bootloader_result = Boot_EnterBootloaderMode(&event);
         if (bootloader_result == BOOT_STATE_APPLICATION_JUMP) {
             const char jump_to_app_str[] = "Jump To APP\n";
-            boot_send_func((uint8_t *)jump_to_app_str, strlen(jump_to_app_str));
+            Boot_SendString(jump_to_app_str, strlen(jump_to_app_str));
             current_boot_state = BOOT_STATE_APPLICATION_JUMP;
         }
         break;
 
-    case BOOT_STATE_APPLICATION_JUMP:
-        if (Boot_IsApplicationValid()) {
+    case BOOT_STATE_APPLICATION_JUMP: {
+        // 累计未确认固件的启动次数，超限自动回滚
+        Boot_SlotSelectBoot();
+        uint8_t app_valid = Boot_IsApplicationValid();
+        if (!app_valid && Boot_SlotRollback() == ERROR_CODE_NO_ERROR) {
+            // 当前槽固件无效，回滚到另一个槽后重新校验
+            app_valid = Boot_IsApplicationValid();
+        }
+        if (app_valid) {
+            const BootImageReport_t *report = Boot_ImageGetLastReport();
+            char verify_str[64];
+            char *p = Boot_AppendString(verify_str, "Image verified");
+            if (!report->fullScan) {
+                p = Boot_AppendString(p, " (token)");
+            }
+            p = Boot_AppendString(p, ": ");
+            p = Boot_AppendU32(p, report->length);
+            p = Boot_AppendString(p, " bytes, ");
+            p = Boot_AppendU32(p, report->elapsedUs);
+            p = Boot_AppendString(p, " us\n");
+            Boot_SendString(verify_str, (uint16_t)(p - verify_str));
+            Boot_FlushTransports();
             Boot_JumpToApplication();
         } else {
             current_boot_state = BOOT_STATE_BOOTLOADER;
             const char enter_boot_str[] = "Enter BootLoader Mode\n";
-            boot_send_func((uint8_t *)enter_boot_str, strlen(enter_boot_str));
+            Boot_SendString(enter_boot_str, strlen(enter_boot_str));
         }
         break;
+    }
 
     default:
         current_boot_state = BOOT_STATE_BOOTLOADER;
@@ -110,24 +313,73 @@ void Boot_ProcessStateMachine(void) {
 }
 
 uint8_t Boot_IsApplicationValid(void) {
-    const VectorTableType *app_vector_table =
-        (VectorTableType *)APPLICATION_START_ADDRESS;
+    BootSlot_t slot = Boot_SlotGetActive();
+    const BootSlotRegion_t *region = Boot_SlotGetRegion(slot);
 
-    // 检查栈指针是否在有效地址范围内
-    if ((app_vector_table->stack_pointer < 0x20000000) ||
-        (app_vector_table->stack_pointer > 0x20020000)) {
+    // 升级被打断的槽在元数据中是无效的
+    if (!Boot_SlotGetInfo(slot)->valid) {
+        return 0;
+    }
+    uint32_t app_address = Boot_SlotMap(slot);
+    if (app_address == 0) {
+        return 0;
+    }
+    const VectorTableType *app_vector_table = (VectorTableType *)app_address;
+
+    // 检查栈指针是否在某块RAM内（栈顶可等于RAM结束地址）
+    static const struct {
+        uint32_t start;
+        uint32_t end;
+    } ram_regions[] = {
+        {D1_DTCMRAM_BASE, D1_DTCMRAM_BASE + 0x20000},   // DTCM 128KB
+        {D1_AXISRAM_BASE, D1_AXISRAM_BASE + 0x80000},   // AXI SRAM 512KB
+        {D2_AHBSRAM_BASE, D2_AHBSRAM_BASE + 0x48000},   // SRAM1~3 288KB
+        {D3_SRAM_BASE, D3_SRAM_BASE + 0x10000},         // SRAM4 64KB
+    };
+    uint32_t stack_pointer = app_vector_table->stack_pointer;
+    bool stack_valid = false;
+    for (uint32_t i = 0; i < sizeof(ram_regions) / sizeof(ram_regions[0]);
+         i++) {
+        if (stack_pointer > ram_regions[i].start &&
+            stack_pointer <= ram_regions[i].end) {
+            stack_valid = true;
+            break;
+        }
+    }
+    if (!stack_valid) {
         return 0;
     }
 
     // 检查复位处理函数指针是否在有效地址范围内
     uint32_t reset_handler_address = (uint32_t)app_vector_table->reset_handler;
-    if (reset_handler_address < APPLICATION_START_ADDRESS ||
-        reset_handler_address > FLASH_END_ADDRESS) {
+    if (reset_handler_address < app_address ||
+        reset_handler_address >= app_address + region->size) {
         return 0;
     }
 
-    // 检查中断向量表是否包含有效数据
-    uint32_t *app_start_address = (uint32_t *)APPLICATION_START_ADDRESS;
+    // 有固件头时校验整个镜像的CRC32
+    const BootImageHeader_t *header = Boot_ImageGetHeader(app_address);
+    if (header != NULL) {
+        const BootSlotInfo_t *info = Boot_SlotGetInfo(slot);
+        // 固件头与元数据一致且本代固件已校验过，只检查固件头
+        if (Boot_SlotIsVerified(slot) && header->crc32 == info->crc32 &&
+            header->length == info->length) {
+            return Boot_ImageCheckHeader(app_address, region->size) ==
+                   ERROR_CODE_NO_ERROR;
+        }
+        if (Boot_ImageVerify(app_address, region->size) !=
+            ERROR_CODE_NO_ERROR) {
+            return 0;
+        }
+        const BootImageReport_t *report = Boot_ImageGetLastReport();
+        Boot_SlotSetVerified(slot, report->length, report->crc32);
+        return 1;
+    }
+#if BOOT_IMAGE_REQUIRE_HEADER
+    return 0;
+#else
+    // 无固件头的旧镜像：检查中断向量表是否包含有效数据
+    uint32_t *app_start_address = (uint32_t *)app_address;
     for (int i = 0; i < 16; i++) {
         if (app_start_address[i] != 0xFFFFFFFF &&
             app_start_address[i] != 0x00000000) {
@@ -135,34 +387,75 @@ uint8_t Boot_IsApplicationValid(void) {
         }
     }
     return 0;
+#endif
+}
+
+bool Boot_RegisterDeInit(Boot_DeInit_Func deinit_func) {
+    if (deinit_func == NULL || deinit_nums >= BOOT_DEINIT_MAX_NUMS) {
+        return false;
+    }
+    deinit_funcs[deinit_nums++] = deinit_func;
+    return true;
+}
+
+void Boot_SetHandoff(uint32_t handoff) { boot_handoff = handoff; }
+
+uint32_t Boot_GetHandoff(void) {
+    __HAL_RCC_BKPRAM_CLK_ENABLE();
+    uint32_t word = *(volatile uint32_t *)BOOT_HANDOFF_ADDRESS;
+    if ((word & BOOT_HANDOFF_TAG_MASK) != BOOT_HANDOFF_TAG) {
+        return BOOT_HANDOFF_NONE;
+    }
+    return word & ~BOOT_HANDOFF_TAG_MASK;
 }
 
 void Boot_JumpToApplication(void) {
-    const VectorTableType *app_vector_table =
-        (VectorTableType *)APPLICATION_START_ADDRESS;
+    const BootSlotRegion_t *region = Boot_SlotGetRegion(Boot_SlotGetActive());
+    uint32_t app_address = region->execAddress;
+    const VectorTableType *app_vector_table = (VectorTableType *)app_address;
+    uint32_t handoff = boot_handoff;
+
+    // QSPI槽已在校验时切换到内存映射模式，跳转后原地执行，必须保留
+    if (region->storage == BOOT_SLOT_STORAGE_QSPI) {
+        handoff |= BOOT_HANDOFF_QSPI_MMAP;
+    }
 
     // 禁用irq中断，仅关闭IRQ（普通中断），但不关闭FIQ（快速中断）
     __disable_irq();
     // 禁用全部中断
     __set_PRIMASK(1);
 
-    // 复位所有时钟到默认
-    HAL_RCC_DeInit();
+    // 按注册的逆序关闭外设
+    while (deinit_nums > 0) {
+        deinit_funcs[--deinit_nums](handoff);
+    }
     KEY_DeInitDev(&K1);
     LED_DeInitDev(&LED);
+    // 交接标志写入共享RAM，app据此跳过对应的初始化
+    *(volatile uint32_t *)BOOT_HANDOFF_ADDRESS = BOOT_HANDOFF_TAG | handoff;
+    if (!(handoff & BOOT_HANDOFF_CLOCK)) {
+        // 复位所有时钟到默认
+        HAL_RCC_DeInit();
+    }
     // 关闭systick，复位到默认值
     SysTick->CTRL = 0;
     SysTick->LOAD = 0;
     SysTick->VAL = 0;
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
 
-    // 关闭所有中断，清除所有中断挂起标志
-    for (uint32_t i = 0; i < 8; i++) {
+    // 关闭所有中断，清除所有中断挂起标志，字数按NVIC实际实现的中断线数
+    uint32_t nvic_words =
+        (SCnSCB->ICTR & SCnSCB_ICTR_INTLINESNUM_Msk) + 1;
+    if (nvic_words > sizeof(NVIC->ICER) / sizeof(NVIC->ICER[0])) {
+        nvic_words = sizeof(NVIC->ICER) / sizeof(NVIC->ICER[0]);
+    }
+    for (uint32_t i = 0; i < nvic_words; i++) {
         NVIC->ICER[i] = 0xFFFFFFFF;
         NVIC->ICPR[i] = 0xFFFFFFFF;
     }
 
     // 设置中断向量表偏移
-    SCB->VTOR = APPLICATION_START_ADDRESS;
+    SCB->VTOR = app_address;
     // 设置主栈指针
     __set_MSP(app_vector_table->stack_pointer);
     // 使用RTOS时，这句很重要，设置为特权级模式，使用MSP指针
@@ -180,55 +473,131 @@ void Boot_JumpToApplication(void) {
         ;
 }
 
-BootState_t Boot_EnterBootloaderMode(void) {
-    // Bootloader模式实现
-    LED_Blink(&LED, 1000);
-    if (is_recived && bootErrorCode == ERROR_CODE_NO_ERROR) {
-        // 命令处理状态机
-        is_recived = false; // 立即重置
-        Boot_ProcessReceivedCommand();
+bool Boot_IsIdle(void) {
+    return Boot_EventCount() == 0 && !task_yielded &&
+           current_boot_state != BOOT_STATE_APPLICATION_JUMP &&
+           (deferred_slot == BOOT_DEFERRED_NONE || Boot_IsFlashBusy());
+}
+
+bool Boot_IsFlashBusy(void) {
+    return Boot_TaskIsRunning(&upload_task) ||
+           Boot_TaskIsRunning(&verify_task) ||
+           Boot_TaskIsRunning(&block_crc_task);
+}
+
+uint32_t Boot_GetUs(void) {
+    uint32_t ms;
+    uint32_t val;
+    // 读取期间SysTick中断可能更新毫秒计数，前后不一致时重读
+    do {
+        ms = HAL_GetTick();
+        val = SysTick->VAL;
+    } while (ms != HAL_GetTick());
+    return ms * 1000U +
+           (SysTick->LOAD - val) * 1000U / (SysTick->LOAD + 1);
+}
+
+void Boot_TickHandler(void) {
+    if (boot_initialized && !wait_timeout_posted &&
+        current_boot_state == BOOT_STATE_WAIT &&
+        HAL_GetTick() > BOOT_WAIT_TIME_MS) {
+        wait_timeout_posted = Boot_EventPost(BOOT_EVENT_TIMEOUT, 0, 0);
+    }
+}
+
+BootState_t Boot_EnterBootloaderMode(const BootEvent_t *event) {
+    // Bootloader模式实现，LED由led任务驱动
+    switch (event->type) {
+    case BOOT_EVENT_FRAME: {
+        command_frame_t *frame = Boot_FrameGet(event->arg);
+        // 擦写或校验期间只立即处理ACK、ABORT和STATUS，其他命令暂存一个，
+        // 再有命令就丢弃并上报，上位机应等待应答后再发
+        if (Boot_IsFlashBusy() && frame->command != CMD_ACK &&
+            frame->command != CMD_ABORT && frame->command != CMD_STATUS) {
+            if (deferred_slot == BOOT_DEFERRED_NONE) {
+                deferred_slot = event->arg;
+            } else {
+                Boot_FrameRelease(event->arg);
+                Boot_SendErrorResponse(ERROR_CODE_PARSE_FAILED);
+            }
+            Boot_SetTransportBusy(active_transport, false);
+            break;
+        }
+        // 命令处理，帧槽在处理完之前不会被新的帧覆盖
+        bootErrorCode = ERROR_CODE_NO_ERROR;
+        Boot_ProcessReceivedCommand(frame);
+        Boot_FrameRelease(event->arg);
+        Boot_SetTransportBusy(active_transport, false);
+        if (bootErrorCode != ERROR_CODE_NO_ERROR) {
+            // 给上位机发送错误消息，利用command_build_frame打包，
+            // 命令字为CMD_ERROR_RESPONSE 数据为错误信息表
+            Boot_SendErrorResponse(bootErrorCode);
+            bootErrorCode = ERROR_CODE_NO_ERROR; // 重置错误码
+        }
         if (is_run_app) {
             is_run_app = false;
             return BOOT_STATE_APPLICATION_JUMP;
         }
-
-    } else if (bootErrorCode != ERROR_CODE_NO_ERROR) {
-        // 给上位机发送错误消息，利用command_build_frame打包，
-        // 命令字为CMD_ERROR_RESPONSE 数据为错误信息表
-        // 写一个错误信息表用来根据错误号给上位机反馈错误信息
-        Boot_SendErrorResponse(bootErrorCode);
-        bootErrorCode = ERROR_CODE_NO_ERROR; // 重置错误码
+        break;
     }
 
-    if (KEY_GetState(&K1) == KEY_State_DOWN) {
-        return BOOT_STATE_APPLICATION_JUMP;
+    case BOOT_EVENT_PARSE_ERROR:
+        Boot_SendErrorResponse((BootErrorCode_t)event->arg);
+        break;
+
+    case BOOT_EVENT_KEY:
+        // 擦写或校验中不跳转，避免启动写了一半的槽
+        if (event->arg == KEY_State_DOWN && !Boot_IsFlashBusy()) {
+            return BOOT_STATE_APPLICATION_JUMP;
+        }
+        break;
+
+    default:
+        // 发送完成等事件只用于唤醒主循环
+        break;
     }
     return BOOT_STATE_BOOTLOADER;
 }
 
 /**
  * @brief 处理接收到的命令
+ * @param frame 帧槽中的命令帧
  */
-static void Boot_ProcessReceivedCommand(void) {
-    switch (current_frame.command) {
+static void Boot_ProcessReceivedCommand(command_frame_t *frame) {
+    switch (frame->command) {
     case CMD_ENTER_BOOT:
+        // 数据第1字节为上位机请求的帧校验方式，不支持或没有时使用8位和校验
+        frame_check = FRAME_CHECK_SUM8;
+        if (frame->data_length >= 1 &&
+            frame->data[0] < FRAME_CHECK_NUMS) {
+            frame_check = (frame_check_t)frame->data[0];
+        }
+        // 应答固定用8位和校验发出，之后的帧使用协商的校验方式
+        command_parser_set_check(&active_transport->parser, frame_check);
+        // 新会话重新开始按地址上传
+        record_session = false;
         // 已经进入Bootloader，发送确认
         Boot_SendEnterBootResponse();
         break;
 
     case CMD_UPLOAD:
-        // 处理固件上传
-        bootErrorCode = Boot_ProcessUploadCommand(&current_frame);
-        if (bootErrorCode == ERROR_CODE_NO_ERROR) {
-            // 没错误回复ack
-            Boot_SendAckResponse();
-        }
+        // 处理固件上传，写入完成后由upload任务回复ack
+        bootErrorCode = Boot_ProcessUploadCommand(frame);
+        break;
+
+    case CMD_UPLOAD_RECORD:
+        // 按地址上传，写入完成后由upload任务回复ack
+        bootErrorCode = Boot_ProcessRecordCommand(frame);
         break;
 
     case CMD_VERIFY:
-        // 处理验证命令
-        // Boot_ProcessVerifyCommand(&current_frame);
-        Boot_SendAckResponse(); // 暂时只回复ACK
+        // 处理验证命令，固件完整时由verify任务校验并切换启动槽
+        bootErrorCode = Boot_ProcessVerifyCommand();
+        break;
+
+    case CMD_BLOCK_CRC:
+        // 按块计算候选槽的CRC32，完成后由block_crc任务应答
+        bootErrorCode = Boot_ProcessBlockCRCCommand(frame);
         break;
 
     case CMD_RUN_APP:
@@ -242,6 +611,17 @@ static void Boot_ProcessReceivedCommand(void) {
         Boot_SendAckResponse();
         break;
 
+    case CMD_ABORT:
+        // 中止正在进行的擦写或校验
+        Boot_ProcessAbortCommand();
+        Boot_SendAckResponse();
+        break;
+
+    case CMD_STATUS:
+        // 查询状态和进度
+        Boot_SendStatusResponse();
+        break;
+
     default:
         Boot_SendErrorResponse(ERROR_CODE_PARSE_UNKNOWN_CMD);
         break;
@@ -254,68 +634,867 @@ static void Boot_ProcessReceivedCommand(void) {
  */
 BootErrorCode_t Boot_ProcessUploadCommand(command_frame_t *frame) {
     // 验证命令帧或者命令帧中固件数据是否为空
-    //  (sizeof(firmwareInfo_t) - DEVICE_INFO_FIRMWARE_PACKET_SIZE)==12
-    // 包号+总包数+crc32的==12字节
+    // 包号+总包数+crc32共BOOT_FIRMWARE_PACKET_HEADER_SIZE字节
+    // 数据不能超过本次会话协商的包大小
     if (frame == NULL ||
-        frame->data_length <
-            (sizeof(firmwareInfo_t) - DEVICE_INFO_FIRMWARE_PACKET_SIZE)) {
+        frame->data_length < BOOT_FIRMWARE_PACKET_HEADER_SIZE ||
+        frame->data_length >
+            BOOT_FIRMWARE_PACKET_HEADER_SIZE + firmware_packet_size) {
         return ERROR_CODE_FIRMWARE_INVALID_DATA;
     }
 
-    // 初始化固件缓冲区为0xFF（Flash擦除状态）
-    memset(firmwareInfo.rawDate, 0xFF, sizeof(firmwareInfo_t));
-    // 内存拷贝确保数据对齐，按实际数据长度写入
+    // 内存拷贝确保数据对齐，按实际数据长度写入，不足一包时不再填充整包
     memcpy(firmwareInfo.rawDate, frame->data, frame->data_length);
     // 快速验证包序号
     if (firmwareInfo.firmwareInfo.packetNum >=
-        firmwareInfo.firmwareInfo.packetTotalNum) {
+            firmwareInfo.firmwareInfo.packetTotalNum ||
+        firmwareInfo.firmwareInfo.packetTotalNum > BOOT_RESUME_MAX_PACKETS) {
         return ERROR_CODE_FIRMWARE_INVALID_DATA;
     }
-    // 验证CRC32
-    // todo 验证crc32
-    return Boot_FlashProgram();
-    // return ERROR_CODE_NO_ERROR;
-}
-BootErrorCode_t Boot_FlashProgram() {
-    // 计算flash地址
-    uint32_t flashAddr = (firmwareInfo.firmwareInfo.packetNum *
-                          DEVICE_INFO_FIRMWARE_PACKET_SIZE) +
-                         APPLICATION_START_ADDRESS;
-    // 验证地址对齐（闪存字需要32字节对齐）
-    if ((flashAddr & 0x1F) != 0) {
+    // 后续包必须属于当前会话，复位后进度丢失时需从第一包重新上传
+    if (firmwareInfo.firmwareInfo.packetNum != 0 &&
+        (Boot_ResumeSession(firmware_packet_size) == 0 ||
+         Boot_ResumeTotal() != firmwareInfo.firmwareInfo.packetTotalNum)) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    // 验证包头中的数据CRC32，不一致时不写入
+    BootErrorCode_t err = ERROR_CODE_NO_ERROR;
+    uint32_t length = frame->data_length - BOOT_FIRMWARE_PACKET_HEADER_SIZE;
+    uint32_t crc = command_calc_check(
+        FRAME_CHECK_CRC32, firmwareInfo.firmwareInfo.firmware, length);
+    if (crc != firmwareInfo.firmwareInfo.packetCRC32) {
+        return ERROR_CODE_FIRMWARE_VERIFY_FAILED;
+    }
+    // 已写入的包不再写flash：上位机没收到ACK而重发时直接应答
+    if (Boot_IsRepeatedPacket(firmwareInfo.firmwareInfo.packetNum,
+                              firmwareInfo.firmwareInfo.packetTotalNum,
+                              firmwareInfo.firmwareInfo.firmware, length, crc,
+                              &err)) {
+        if (err == ERROR_CODE_NO_ERROR) {
+            boot_status.packetsRepeated++;
+            Boot_SendAckResponse();
+        }
+        return err;
+    }
+    upload_op.crc32 = crc;
+    // 新一次上传从第一包开始统计
+    if (firmwareInfo.firmwareInfo.packetNum == 0) {
+        boot_status.bytesReceived = 0;
+        boot_status.bytesProgrammed = 0;
+        boot_status.bytesErased = 0;
+        boot_status.sectorsErased = 0;
+        boot_status.packetsRepeated = 0;
+    }
+    boot_status.bytesReceived += length;
+    upload_op.erase = firmwareInfo.firmwareInfo.packetNum == 0
+                          ? BOOT_UPLOAD_ERASE_SLOT
+                          : BOOT_UPLOAD_ERASE_NONE;
+    upload_op.slotLength =
+        firmwareInfo.firmwareInfo.packetTotalNum * firmware_packet_size;
+    upload_op.offset =
+        firmwareInfo.firmwareInfo.packetNum * firmware_packet_size;
+    upload_op.length = length;
+    upload_op.data = firmwareInfo.firmwareInfo.firmware;
+    // 擦写在upload任务中分步执行，任务结束前不会再接收固件包，firmwareInfo不会被改写
+    if (!Boot_TaskStart(&upload_task)) {
         return ERROR_CODE_FIRMWARE_FLASH_ERROR;
     }
+    operation_start_us = Boot_GetUs();
+    return ERROR_CODE_NO_ERROR;
+}
+
+/**
+ * @brief 清空最近写入的包记录，新会话开始时调用
+ */
+static void Boot_ClearUploadHistory(void) {
+    for (uint8_t i = 0; i < BOOT_UPLOAD_HISTORY_NUMS; i++) {
+        upload_history[i].packetNum = BOOT_UPLOAD_HISTORY_NONE;
+    }
+}
 
-    // 解锁Flash
-    if (HAL_FLASH_Unlock() != HAL_OK) {
+/**
+ * @brief 判断是否为本次会话中已写入的包
+ * @details 最近写入过同一包号时比较数据CRC，更早写入的包与flash中的内容比较，
+ *          不同说明上位机发错了包，返回ERROR_CODE_FIRMWARE_INVALID_DATA。
+ *          第一包CRC不同或不在记录中时视为重新开始上传
+ * @param data 包数据
+ * @param length 包数据长度
+ * @param err 重复但内容不同时返回错误码
+ * @return true 已写入，不再写flash
+ */
+static bool Boot_IsRepeatedPacket(uint32_t packet_num, uint32_t packet_total,
+                                  const uint8_t *data, uint32_t length,
+                                  uint32_t crc, BootErrorCode_t *err) {
+    if (Boot_ResumeSession(firmware_packet_size) == 0 ||
+        Boot_ResumeTotal() != packet_total || !Boot_ResumeIsDone(packet_num)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < BOOT_UPLOAD_HISTORY_NUMS; i++) {
+        if (upload_history[i].packetNum != packet_num) {
+            continue;
+        }
+        if (upload_history[i].crc32 == crc) {
+            return true;
+        }
+        if (packet_num == 0) {
+            return false;
+        }
+        *err = ERROR_CODE_FIRMWARE_INVALID_DATA;
+        return true;
+    }
+    if (packet_num == 0) {
+        return false;
+    }
+    // 不在最近的记录中，续传进度只说明写过，内容要与flash比较
+    uint32_t address = Boot_SlotMap(Boot_SlotGetCandidate());
+    if (address == 0) {
+        *err = ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    } else if (memcmp((const uint8_t *)(address +
+                                        packet_num * firmware_packet_size),
+                      data, length) != 0) {
+        *err = ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    return true;
+}
+
+/**
+ * @brief 处理按地址上传指令：只擦除和写入记录覆盖的范围
+ * @param frame 命令帧
+ * @return 错误码
+ */
+static BootErrorCode_t Boot_ProcessRecordCommand(command_frame_t *frame) {
+    const firmwareRecord_t *record = &firmwareInfo.firmwareRecord;
+    uint32_t data_length;
+
+    if (frame == NULL ||
+        frame->data_length < BOOT_FIRMWARE_PACKET_HEADER_SIZE ||
+        frame->data_length >
+            BOOT_FIRMWARE_PACKET_HEADER_SIZE + firmware_packet_size) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    memcpy(firmwareInfo.rawDate, frame->data, frame->data_length);
+    data_length = frame->data_length - BOOT_FIRMWARE_PACKET_HEADER_SIZE;
+    if (record->length == 0) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    // 数据长度与记录一致，不要求对齐，由写合并缓冲凑成闪存字
+    if ((record->flags & BOOT_RECORD_FLAG_ERASE) == 0
+            ? record->length != data_length
+            : data_length != 0) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    // 槽范围由Boot_SlotEraseRangeBegin检查
+    if (!record_session) {
+        // 新一次上传从第一条记录开始统计
+        boot_status.bytesReceived = 0;
+        boot_status.bytesProgrammed = 0;
+        boot_status.bytesErased = 0;
+        boot_status.sectorsErased = 0;
+    }
+    boot_status.bytesReceived += data_length;
+    upload_op.erase = BOOT_UPLOAD_ERASE_RANGE;
+    upload_op.slotLength = 0;
+    upload_op.offset = record->address;
+    upload_op.length = record->length;
+    upload_op.data = (record->flags & BOOT_RECORD_FLAG_ERASE) != 0
+                         ? NULL
+                         : record->data;
+    if (!Boot_TaskStart(&upload_task)) {
         return ERROR_CODE_FIRMWARE_FLASH_ERROR;
     }
-    uint8_t *data_ptr = firmwareInfo.firmwareInfo.firmware;
-    // flash编程的闪存字数（256位 = 32字节）
-    for (uint32_t byte_offset = 0;
-         byte_offset < DEVICE_INFO_FIRMWARE_PACKET_SIZE;
-         byte_offset += 32) { // 每次步进32字节
-        // 编程数据
+    operation_start_us = Boot_GetUs();
+    return ERROR_CODE_NO_ERROR;
+}
+
+/**
+ * @brief 固件写入任务：第一包先擦除候选槽，按地址上传时先擦除记录覆盖的块，
+ *        再写入数据，完成后回复ack
+ * @details 每启动一块擦除或一页编程就让出，硬件忙时允许主循环睡眠
+ */
+static BootTaskStatus_t Boot_UploadTask(BootTask_t *task) {
+    // 跨让出点保留的错误码、当前阶段，以及本次擦除前的累计擦除量
+    static BootErrorCode_t err;
+    static bool erasing;
+    static bool writing;
+    static uint32_t erased_bytes;
+    static uint32_t erased_blocks;
+    // 固件写入候选槽，当前启动槽保持不变，用于回滚
+    BootSlot_t slot = Boot_SlotGetCandidate();
+    uint32_t packetNum = firmwareInfo.firmwareInfo.packetNum;
+    uint32_t packetTotalNum = firmwareInfo.firmwareInfo.packetTotalNum;
+    BootSlotJobState_t state;
+
+    BOOT_TASK_BEGIN(task);
+    erased_bytes = boot_status.bytesErased;
+    erased_blocks = boot_status.sectorsErased;
+    erasing = true;
+    writing = false;
+    if (upload_op.erase != BOOT_UPLOAD_ERASE_NONE &&
+        (upload_op.erase == BOOT_UPLOAD_ERASE_SLOT || !record_session)) {
+        // 重新开始上传，丢弃上一次暂存的数据
+        Boot_CombineReset(&write_combine);
+    }
+    if (upload_op.erase == BOOT_UPLOAD_ERASE_SLOT) {
+        // 第一包：作废并擦除候选槽，开始新的续传会话
+        upload_length = 0;
+        record_session = false;
+        err = Boot_SlotEraseBegin(&slot_job, slot, upload_op.slotLength);
+        if (err == ERROR_CODE_NO_ERROR) {
+            uint32_t id = Boot_GetCycles() ^ (Boot_GetUs() * 0x9E3779B1U);
+            Boot_ResumeStart(id != 0 ? id : 1, firmware_packet_size,
+                             packetTotalNum);
+            Boot_ClearUploadHistory();
+        }
+    } else if (upload_op.erase == BOOT_UPLOAD_ERASE_RANGE) {
+        err = ERROR_CODE_NO_ERROR;
+        if (!record_session) {
+            // 第一条记录：作废候选槽，之后每块只在第一次写到时擦除
+            upload_length = 0;
+            Boot_ResumeClear();
+            err = Boot_SlotInvalidate(slot);
+            record_session = (err == ERROR_CODE_NO_ERROR);
+        }
+        if (err == ERROR_CODE_NO_ERROR) {
+            err = Boot_SlotEraseRangeBegin(&slot_job, slot, upload_op.offset,
+                                           upload_op.length);
+        }
+    } else {
+        erasing = false;
+        err = Boot_UploadWriteBegin(slot, &writing);
+    }
+    while (err == ERROR_CODE_NO_ERROR && (erasing || writing) &&
+           !BOOT_TASK_ABORTED(task)) {
+        state = Boot_SlotJobStep(&slot_job);
+        if (erasing) {
+            boot_status.bytesErased = erased_bytes + slot_job.done;
+            boot_status.sectorsErased = erased_blocks + slot_job.blocks;
+        }
+        if (state == BOOT_SLOT_JOB_DONE) {
+            if (writing) {
+                boot_status.bytesProgrammed += slot_job.done;
+                writing = false;
+            } else {
+                // 擦除完成，接着写入数据，只擦除的记录到此结束
+                erasing = false;
+                if (upload_op.data != NULL) {
+                    err = Boot_UploadWriteBegin(slot, &writing);
+                }
+            }
+        } else if (state == BOOT_SLOT_JOB_ERROR) {
+            err = ERROR_CODE_FIRMWARE_FLASH_ERROR;
+        } else if (state == BOOT_SLOT_JOB_BUSY) {
+            BOOT_TASK_WAIT(task);
+        } else {
+            BOOT_TASK_YIELD(task);
+        }
+    }
+    // 中止时等正在执行的擦写结束，之后才能再次访问flash
+    BOOT_TASK_WAIT_UNTIL(task, !Boot_SlotJobBusy(&slot_job));
+    if (BOOT_TASK_ABORTED(task)) {
+        // 中止命令已经回复过
+        BOOT_TASK_EXIT(task);
+    }
+    if (err != ERROR_CODE_NO_ERROR) {
+        Boot_SendErrorResponse(err);
+        BOOT_TASK_EXIT(task);
+    }
+    if (upload_op.erase == BOOT_UPLOAD_ERASE_RANGE) {
+        // 按地址上传没有总包数，镜像长度以固件头为准，校验上限为整个槽
+        upload_length = Boot_SlotGetRegion(slot)->size;
+    } else {
+        // 只有最后一包会留下暂存数据，立即写出，续传进度与flash内容一致
+        err = Boot_CombineFlush(slot);
+        if (err != ERROR_CODE_NO_ERROR) {
+            Boot_SendErrorResponse(err);
+            BOOT_TASK_EXIT(task);
+        }
+        Boot_ResumeMark(packetNum);
+        upload_history[upload_history_pos].packetNum = packetNum;
+        upload_history[upload_history_pos].crc32 = upload_op.crc32;
+        upload_history_pos =
+            (upload_history_pos + 1) % BOOT_UPLOAD_HISTORY_NUMS;
+        upload_length = Boot_ResumeImageLength();
+    }
+    Boot_SendAckResponse();
+    BOOT_TASK_END(task);
+}
+
+/**
+ * @brief 写出写合并缓冲中暂存的闪存字
+ * @details 先读回闪存字的原内容合并：之前写出过一部分的闪存字（CMD_VERIFY
+ *          之后续写、按地址上传的记录接续）保留已写入的字节，不会被0xFF
+ *          填充覆盖；合并后与flash相同时不再编程
+ */
+static BootErrorCode_t Boot_CombineFlush(BootSlot_t slot) {
+    uint8_t flash[BOOT_FLASH_WORD_SIZE] ALIGNED(4);
+    bool program = false;
+    BootErrorCode_t err;
 
-        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_FLASHWORD,
-                              flashAddr + byte_offset, // 直接使用字节偏移
-                              (uint32_t)(data_ptr + byte_offset)) != HAL_OK) {
-            HAL_FLASH_Lock();
-            return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    if (!Boot_CombinePending(&write_combine)) {
+        return ERROR_CODE_NO_ERROR;
+    }
+    err = Boot_SlotRead(slot, write_combine.offset, flash, BOOT_FLASH_WORD_SIZE);
+    if (err == ERROR_CODE_NO_ERROR) {
+        err = Boot_CombineMerge(&write_combine, flash,
+                                Boot_SlotReprogrammable(slot), &program);
+    }
+    // 只有一个闪存字，直接阻塞写入
+    if (err == ERROR_CODE_NO_ERROR && program) {
+        err = Boot_SlotWrite(slot, write_combine.offset, write_combine.word,
+                             BOOT_FLASH_WORD_SIZE);
+    }
+    if (err == ERROR_CODE_NO_ERROR) {
+        boot_status.bytesProgrammed += Boot_CombineLength(&write_combine);
+    }
+    Boot_CombineReset(&write_combine);
+    return err;
+}
+
+/**
+ * @brief 开始写入upload_op中的数据
+ * @details 开头不满一个闪存字的部分并入写合并缓冲，凑满时写出；中间按闪存字
+ *          对齐的部分由slot_job分步写入；结尾不满一个闪存字的部分暂存，
+ *          等下一段数据或CMD_VERIFY时写出
+ * @param writing 返回是否启动了分步写入
+ * @return 与暂存数据重叠或写入失败时返回错误码
+ */
+static BootErrorCode_t Boot_UploadWriteBegin(BootSlot_t slot, bool *writing) {
+    uint32_t word = upload_op.offset & ~(BOOT_FLASH_WORD_SIZE - 1);
+    uint32_t size;
+    BootErrorCode_t err;
+
+    *writing = false;
+    if (upload_op.length == 0) {
+        return ERROR_CODE_NO_ERROR;
+    }
+    if (Boot_CombinePending(&write_combine) && write_combine.offset != word) {
+        // 地址不连续，暂存的闪存字不会再有数据
+        err = Boot_CombineFlush(slot);
+        if (err != ERROR_CODE_NO_ERROR) {
+            return err;
         }
     }
-    HAL_FLASH_Lock();
+    if (upload_op.offset != word || Boot_CombinePending(&write_combine)) {
+        size = Boot_CombinePut(&write_combine, upload_op.offset, upload_op.data,
+                               upload_op.length);
+        if (size == 0) {
+            // 与已暂存的数据重叠
+            return ERROR_CODE_FIRMWARE_INVALID_DATA;
+        }
+        upload_op.offset += size;
+        upload_op.data += size;
+        upload_op.length -= size;
+        if (Boot_CombineFull(&write_combine)) {
+            err = Boot_CombineFlush(slot);
+            if (err != ERROR_CODE_NO_ERROR) {
+                return err;
+            }
+        }
+    }
+    // 此时upload_op已写完，或offset按闪存字对齐且没有暂存数据
+    size = upload_op.length & ~(BOOT_FLASH_WORD_SIZE - 1);
+    if (upload_op.length > size) {
+        Boot_CombinePut(&write_combine, upload_op.offset + size,
+                        upload_op.data + size, upload_op.length - size);
+    }
+    if (size == 0) {
+        return ERROR_CODE_NO_ERROR;
+    }
+    *writing = true;
+    return Boot_SlotWriteBegin(&slot_job, slot, upload_op.offset,
+                               upload_op.data, size);
+}
+
+/**
+ * @brief 处理验证命令：固件全部写入后校验固件头和CRC32，
+ *        通过后标记候选槽有效并切换为启动槽
+ * @details 这里只检查固件头，整镜像CRC由verify任务分段计算，完成后回复ack
+ * @return 错误码
+ */
+static BootErrorCode_t Boot_ProcessVerifyCommand(void) {
+    if (upload_length == 0) {
+        // 复位前已写完全部包时从续传进度恢复
+        upload_length = Boot_ResumeImageLength();
+    }
+    if (upload_length == 0) {
+        // 没有完整上传的固件，不切换
+        Boot_SendAckResponse();
+        return ERROR_CODE_NO_ERROR;
+    }
+    // 上传结束，先写出暂存的最后一个闪存字
+    BootErrorCode_t err = Boot_CombineFlush(Boot_SlotGetCandidate());
+    if (err != ERROR_CODE_NO_ERROR) {
+        return err;
+    }
+    uint32_t app_address = Boot_SlotMap(Boot_SlotGetCandidate());
+    if (app_address == 0) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    err = Boot_ImageVerifyBegin(&verify_job, app_address, upload_length);
+    if (err != ERROR_CODE_NO_ERROR) {
+        upload_length = 0;
+        Boot_ResumeClear();
+        return err;
+    }
+    if (!Boot_TaskStart(&verify_task)) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    operation_start_us = Boot_GetUs();
     return ERROR_CODE_NO_ERROR;
 }
 
+/**
+ * @brief 整镜像校验任务，每计算BOOT_IMAGE_VERIFY_STEP_SIZE字节让出一次
+ */
+static BootTaskStatus_t Boot_VerifyTask(BootTask_t *task) {
+    BootSlot_t slot = Boot_SlotGetCandidate();
+    BootErrorCode_t err;
+
+    BOOT_TASK_BEGIN(task);
+    while (!Boot_ImageVerifyStep(&verify_job, BOOT_IMAGE_VERIFY_STEP_SIZE)) {
+        if (BOOT_TASK_ABORTED(task)) {
+            BOOT_TASK_EXIT(task);
+        }
+        BOOT_TASK_YIELD(task);
+    }
+    err = Boot_ImageVerifyEnd(&verify_job);
+    if (err == ERROR_CODE_NO_ERROR) {
+        // 元数据只有一个flash字，直接提交
+        const BootImageReport_t *report = Boot_ImageGetLastReport();
+        err = Boot_SlotFinishUpdate(slot, report->version, report->length,
+                                    report->crc32);
+    }
+    if (err == ERROR_CODE_NO_ERROR) {
+        err = Boot_SlotActivate(slot);
+    }
+    upload_length = 0;
+    record_session = false;
+    Boot_ResumeClear();
+    if (err != ERROR_CODE_NO_ERROR) {
+        Boot_SendErrorResponse(err);
+    } else {
+        Boot_SendAckResponse();
+    }
+    BOOT_TASK_END(task);
+}
+
+/**
+ * @brief 处理块CRC命令：按擦除块计算候选槽内容的CRC32
+ * @details 按地址上传时没有写到的块保持原内容，上位机据此只发送变化的块；
+ *          写合并缓冲中还没写出的闪存字在RAM中算进去，不提前写出，
+ *          之后的记录仍可接着填这个闪存字
+ * @return 错误码
+ */
+static BootErrorCode_t Boot_ProcessBlockCRCCommand(command_frame_t *frame) {
+    blockCrcInfo_t *info = &block_crc.blockCrcInfo;
+    BootSlot_t slot = Boot_SlotGetCandidate();
+    uint32_t slot_size = Boot_SlotGetRegion(slot)->size;
+    uint32_t first = 0;
+    uint32_t nums = 0;
+
+    // 请求数据可省略，blockNum为0时尽量多
+    if (frame->data_length >= 4) {
+        memcpy(&first, frame->data, 4);
+    }
+    if (frame->data_length >= 8) {
+        memcpy(&nums, frame->data + 4, 4);
+    }
+    info->blockSize = Boot_SlotBlockSize(slot);
+    if (info->blockSize > slot_size) {
+        info->blockSize = slot_size;
+    }
+    info->blockTotal = (slot_size + info->blockSize - 1) / info->blockSize;
+    if (first >= info->blockTotal) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    if (nums == 0 || nums > BOOT_BLOCK_CRC_MAX_NUMS) {
+        nums = BOOT_BLOCK_CRC_MAX_NUMS;
+    }
+    if (nums > info->blockTotal - first) {
+        nums = info->blockTotal - first;
+    }
+    info->slotAddress = Boot_SlotMap(slot);
+    if (info->slotAddress == 0) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    info->firstBlock = first;
+    info->blockNum = 0;
+    block_crc_nums = nums;
+    if (!Boot_TaskStart(&block_crc_task)) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    operation_start_us = Boot_GetUs();
+    return ERROR_CODE_NO_ERROR;
+}
+
+/**
+ * @brief 块CRC任务，每算完一块让出一次，全部算完后发送应答
+ */
+static BootTaskStatus_t Boot_BlockCRCTask(BootTask_t *task) {
+    blockCrcInfo_t *info = &block_crc.blockCrcInfo;
+    uint32_t slot_size = Boot_SlotGetRegion(Boot_SlotGetCandidate())->size;
+
+    BOOT_TASK_BEGIN(task);
+    while (info->blockNum < block_crc_nums) {
+        if (BOOT_TASK_ABORTED(task)) {
+            BOOT_TASK_EXIT(task);
+        }
+        uint32_t offset = (info->firstBlock + info->blockNum) * info->blockSize;
+        uint32_t length = slot_size - offset < info->blockSize
+                              ? slot_size - offset
+                              : info->blockSize;
+        if (Boot_CombinePending(&write_combine) &&
+            write_combine.offset - offset < length) {
+            // 暂存的闪存字按写出后的内容计算
+            uint8_t word[BOOT_FLASH_WORD_SIZE] ALIGNED(4);
+            memcpy(word,
+                   (const uint8_t *)(info->slotAddress + write_combine.offset),
+                   BOOT_FLASH_WORD_SIZE);
+            Boot_CombineView(&write_combine, word);
+            info->crc32[info->blockNum] = Boot_ImageBlockCRCPatched(
+                info->slotAddress + offset, length,
+                write_combine.offset - offset, word, BOOT_FLASH_WORD_SIZE);
+        } else {
+            info->crc32[info->blockNum] =
+                Boot_ImageBlockCRC(info->slotAddress + offset, length);
+        }
+        info->blockNum++;
+        BOOT_TASK_YIELD(task);
+    }
+    Boot_SendFrame(CMD_BLOCK_CRC, block_crc.rawData,
+                   (uint16_t)(offsetof(blockCrcInfo_t, crc32) +
+                              info->blockNum * sizeof(uint32_t)));
+    BOOT_TASK_END(task);
+}
+
+/**
+ * @brief 中止擦写和校验并丢弃暂存的命令帧，之后需要从第一包重新上传
+ */
+static void Boot_ProcessAbortCommand(void) {
+    Boot_TaskAbort(&upload_task);
+    Boot_TaskAbort(&verify_task);
+    Boot_TaskAbort(&block_crc_task);
+    upload_length = 0;
+    record_session = false;
+    Boot_ResumeClear();
+    Boot_CombineReset(&write_combine);
+    if (deferred_slot != BOOT_DEFERRED_NONE) {
+        Boot_FrameRelease(deferred_slot);
+        deferred_slot = BOOT_DEFERRED_NONE;
+    }
+}
+
+/**
+ * @brief 轮询没有接收中断的通道，每轮主循环执行一次
+ */
+static BootTaskStatus_t Boot_RxTask(BootTask_t *task) {
+    BOOT_TASK_BEGIN(task);
+    while (1) {
+        Boot_PollTransports();
+        BOOT_TASK_WAIT(task);
+    }
+    BOOT_TASK_END(task);
+}
+
+/**
+ * @brief Bootloader模式下的LED指示：空闲慢闪，擦写和校验时快闪
+ */
+static BootTaskStatus_t Boot_LedTask(BootTask_t *task) {
+    BOOT_TASK_BEGIN(task);
+    while (1) {
+        if (current_boot_state == BOOT_STATE_BOOTLOADER) {
+            LED_Blink(&LED, Boot_IsFlashBusy() ? 100 : 1000);
+        }
+        BOOT_TASK_WAIT(task);
+    }
+    BOOT_TASK_END(task);
+}
+
 /**
  * @brief 发送命令帧
  */
 static bool Boot_SendFrame(command_type_t cmd, uint8_t *data,
                            uint16_t data_len) {
-    uint8_t tx_buffer[FRAME_SIZE];
-    uint16_t frame_len = command_build_frame(cmd, data, data_len, tx_buffer);
-    return boot_send_func(tx_buffer, frame_len);
+    BootTransport_t *transport = active_transport;
+    if (transport == NULL) {
+        return false;
+    }
+    // 帧在发送缓冲池中构建，不占用栈，通道异步发送时也不会失效
+    uint8_t *tx_buffer = Boot_TxBufAllocWait(
+        (uint16_t)(FRAME_SIZE - FRAME_DATA_SIZE + data_len));
+    if (tx_buffer == NULL) {
+        return false;
+    }
+    uint16_t frame_len =
+        command_build_frame_ex(cmd, data, data_len, frame_check, tx_buffer);
+    return Boot_TransportSend(transport, tx_buffer, frame_len);
+}
+
+/**
+ * @brief 申请发送缓冲，池用完时等待通道发送完成释放，超时返回NULL
+ */
+static uint8_t *Boot_TxBufAllocWait(uint16_t size) {
+    uint32_t start = HAL_GetTick();
+    uint8_t *buffer;
+    while ((buffer = Boot_TxBufAlloc(size)) == NULL) {
+        if (size > FRAME_SIZE ||
+            HAL_GetTick() - start > BOOT_TX_ALLOC_TIMEOUT_MS) {
+            return NULL;
+        }
+    }
+    return buffer;
+}
+
+/**
+ * @brief 发送池中的缓冲：零拷贝通道接管缓冲，其他通道发送函数返回时已拷贝完，
+ *        直接释放
+ */
+static bool Boot_TransportSend(BootTransport_t *transport, uint8_t *buffer,
+                               uint16_t length) {
+    if (transport->ops->tx_async != NULL) {
+        if (transport->ops->tx_async(transport, buffer, length)) {
+            return true;
+        }
+        Boot_TxBufRelease(buffer);
+        return false;
+    }
+    bool sent = transport->ops->tx(transport, buffer, length);
+    Boot_TxBufRelease(buffer);
+    return sent;
+}
+
+/**
+ * @brief 追加字符串，返回结尾位置，不写结束符
+ */
+static char *Boot_AppendString(char *p, const char *str) {
+    while (*str != '\0') {
+        *p++ = *str++;
+    }
+    return p;
+}
+
+/**
+ * @brief 按十进制追加无符号数，提示字符串只需要这一种格式，不链接printf
+ */
+static char *Boot_AppendU32(char *p, uint32_t value) {
+    char digits[10];
+    uint8_t count = 0;
+    do {
+        digits[count++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+        *p++ = digits[--count];
+    }
+    return p;
+}
+
+/**
+ * @brief 发送提示字符串：有会话时只发给会话通道，否则发给所有通道
+ */
+static void Boot_SendString(const char *str, uint16_t length) {
+    BootTransport_t *transport = active_transport;
+    if (transport != NULL) {
+        Boot_TransportSendCopy(transport, (const uint8_t *)str, length);
+        return;
+    }
+    for (uint8_t i = 0; i < transport_nums; i++) {
+        Boot_TransportSendCopy(transports[i], (const uint8_t *)str, length);
+    }
+}
+
+/**
+ * @brief 拷贝到发送缓冲后再发，数据可能在调用者栈上
+ */
+static void Boot_TransportSendCopy(BootTransport_t *transport,
+                                   const uint8_t *data, uint16_t length) {
+    uint8_t *buffer = Boot_TxBufAllocWait(length);
+    if (buffer == NULL) {
+        return;
+    }
+    memcpy(buffer, data, length);
+    Boot_TransportSend(transport, buffer, length);
+}
+
+/**
+ * @brief 轮询没有接收中断的通道
+ */
+static void Boot_PollTransports(void) {
+    uint8_t buffer[64];
+    for (uint8_t i = 0; i < transport_nums; i++) {
+        BootTransport_t *transport = transports[i];
+        if (transport->ops->rx == NULL) {
+            continue;
+        }
+        uint16_t length = transport->ops->rx(transport, buffer, sizeof(buffer));
+        Boot_TransportReceive(transport, buffer, length);
+    }
+}
+
+/**
+ * @brief 等待所有通道发送完成，跳转app前调用
+ */
+static void Boot_FlushTransports(void) {
+    for (uint8_t i = 0; i < transport_nums; i++) {
+        if (transports[i]->ops->flush != NULL) {
+            transports[i]->ops->flush(transports[i]);
+        }
+    }
+}
+
+/**
+ * @brief 设置通道忙状态，没有握手的通道忽略
+ */
+static void Boot_SetTransportBusy(BootTransport_t *transport, bool busy) {
+    if (transport != NULL && transport->ops->set_busy != NULL) {
+        transport->ops->set_busy(transport, busy);
+    }
+}
+
+/**
+ * @brief 按通道的最大包长协商固件包大小
+ * @details 扣除帧开销和包信息后向下取整到闪存字，不超过配置的包大小，
+ *          因此每包的片内flash地址和长度都按闪存字对齐
+ */
+static uint16_t Boot_NegotiatePacketSize(BootTransport_t *transport) {
+    uint32_t max_packet = transport->ops->max_packet != NULL
+                              ? transport->ops->max_packet(transport)
+                              : FRAME_SIZE;
+    uint32_t overhead =
+        (FRAME_SIZE - FRAME_DATA_SIZE) + BOOT_FIRMWARE_PACKET_HEADER_SIZE;
+    uint32_t size = DEVICE_INFO_FIRMWARE_PACKET_SIZE;
+
+    if (max_packet < overhead + BOOT_FLASH_WORD_SIZE) {
+        return BOOT_FLASH_WORD_SIZE;
+    }
+    if (max_packet - overhead < size) {
+        size = (max_packet - overhead) & ~(BOOT_FLASH_WORD_SIZE - 1);
+    }
+    return (uint16_t)size;
+}
+
+bool Boot_RegisterTransport(BootTransport_t *transport) {
+    if (transport == NULL || transport->ops == NULL ||
+        transport->ops->tx == NULL || transport->rx_buffer == NULL ||
+        transport_nums >= BOOT_TRANSPORT_MAX_NUMS) {
+        return false;
+    }
+    uint32_t max_packet = transport->ops->max_packet != NULL
+                              ? transport->ops->max_packet(transport)
+                              : FRAME_SIZE;
+    uint32_t overhead = FRAME_SIZE - FRAME_DATA_SIZE;
+    command_parser_setup(&transport->parser, transport->rx_buffer,
+                         transport->rx_buffer_size);
+    command_parser_limit(&transport->parser,
+                         max_packet > overhead ? max_packet - overhead : 0);
+    if (transport->ops->open != NULL && !transport->ops->open(transport)) {
+        return false;
+    }
+    transports[transport_nums++] = transport;
+    return true;
+}
+
+BootTransport_t *Boot_GetActiveTransport(void) { return active_transport; }
+
+/**
+ * @brief 主循环取出帧事件后确定会话通道
+ * @details 最先投递完整命令帧的通道建立会话并协商包大小；会话建立前其他通道
+ *          已投递的帧在这里释放
+ * @return 帧来自会话通道时返回true
+ */
+static bool Boot_ClaimSession(uint8_t slot) {
+    BootTransport_t *transport = frame_transport[slot];
+    if (active_transport == NULL) {
+        firmware_packet_size = Boot_NegotiatePacketSize(transport);
+        active_transport = transport;
+    }
+    if (transport != active_transport) {
+        Boot_FrameRelease(slot);
+        Boot_SetTransportBusy(transport, false);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 把解析器中完成的帧拷贝到帧槽并投递给主循环
+ * @details 没有空闲帧槽或队列满时丢弃该帧并上报解析失败，上位机重发即可
+ */
+BOOT_ITCM static void Boot_PostFrame(BootTransport_t *transport) {
+    uint8_t slot;
+    command_frame_t *frame = Boot_FrameAlloc(&slot);
+    if (frame == NULL) {
+        command_parser_reset(&transport->parser);
+        Boot_EventPost(BOOT_EVENT_PARSE_ERROR, ERROR_CODE_PARSE_FAILED, 0);
+        return;
+    }
+    if (!command_parser_get_frame(&transport->parser, frame)) {
+        Boot_FrameRelease(slot);
+        return;
+    }
+    frame_transport[slot] = transport;
+    Boot_SetTransportBusy(transport, true);
+    if (!Boot_EventPost(BOOT_EVENT_FRAME, slot, 0)) {
+        Boot_FrameRelease(slot);
+        Boot_SetTransportBusy(transport, false);
+    }
+}
+
+void Boot_TransportTxDone(BootTransport_t *transport) {
+    if (boot_initialized && transport == active_transport) {
+        Boot_EventPost(BOOT_EVENT_TX_DONE, 0, 0);
+    }
+}
+
+BOOT_ITCM void Boot_TransportReceive(BootTransport_t *transport,
+                                     const uint8_t *data, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        parse_result_t result =
+            command_parser_process_byte(&transport->parser, data[i]);
+        // 会话建立后忽略其他通道，其解析器照常运行，完整帧直接丢弃
+        if (active_transport != NULL && active_transport != transport) {
+            if (result == PARSE_SUCCESS) {
+                command_parser_reset(&transport->parser);
+            }
+            continue;
+        }
+        switch (result) {
+        case PARSE_SUCCESS:
+            // 会话建立前各通道的帧都投递，由主循环选出会话通道
+            Boot_PostFrame(transport);
+            break;
+        case PARSE_ERROR_HEADER:
+            // 未建立会话时的杂散数据不上报
+            if (active_transport != NULL) {
+                Boot_EventPost(BOOT_EVENT_PARSE_ERROR, ERROR_CODE_PARSE_FAILED,
+                               0);
+            }
+            break;
+        case PARSE_ERROR_INVALID_CMD:
+            if (active_transport != NULL) {
+                Boot_EventPost(BOOT_EVENT_PARSE_ERROR,
+                               ERROR_CODE_PARSE_UNKNOWN_CMD, 0);
+            }
+            break;
+        case PARSE_ERROR_LENGTH:
+            if (active_transport != NULL) {
+                Boot_EventPost(BOOT_EVENT_PARSE_ERROR,
+                               ERROR_CODE_PARSE_ERROR_LENGTH, 0);
+            }
+            break;
+        case PARSE_ERROR_CHECKSUM:
+            if (active_transport != NULL) {
+                Boot_EventPost(BOOT_EVENT_PARSE_ERROR,
+                               ERROR_CODE_PARSE_ERROR_CHECKSUM, 0);
+            }
+            break;
+        case PARSE_INCOMPLETE:
+            // 正常状态，不做处理
+            break;
+        default:
+            break;
+        }
+    }
 }
 /**
  * @brief 发送ACK响应
@@ -337,10 +1516,21 @@ static void Boot_SendEnterBootResponse(void) {
     // 设置flash尺寸
     device.deviceInfo.flashSize = DEVICE_INFO_FLASH_SIZE;
 
-    // 设置app加载地址
-    device.deviceInfo.appAddr = DEVICE_INFO_APP_ADDRESS;
+    // 设置app加载地址，即本次升级写入的候选槽执行地址
+    device.deviceInfo.appAddr =
+        Boot_SlotGetRegion(Boot_SlotGetCandidate())->execAddress;
     // 设置固件包大小
-    device.deviceInfo.firmware_packet = DEVICE_INFO_FIRMWARE_PACKET_SIZE;
+    device.deviceInfo.firmware_packet = firmware_packet_size;
+    // 设置帧校验方式
+    device.deviceInfo.frameCheck = frame_check;
+    // 设置续传会话和缺失的包，包大小与会话不同时不能续传
+    device.deviceInfo.sessionId = Boot_ResumeSession(firmware_packet_size);
+    if (device.deviceInfo.sessionId != 0) {
+        device.deviceInfo.packetTotalNum = Boot_ResumeTotal();
+        device.deviceInfo.packetsDone = Boot_ResumeDoneCount();
+        device.deviceInfo.missingNum = Boot_ResumeGetMissing(
+            device.deviceInfo.missing, BOOT_RESUME_MAX_RANGES);
+    }
     // 设置boot版本
     strncpy(device.deviceInfo.bootVersion, DEVICE_INFO_BOOT_VERSION,
             DEVICE_INFO_BOOT_VERSION_LENGTH - 1);
@@ -354,43 +1544,42 @@ static void Boot_SendEnterBootResponse(void) {
  */
 static void Boot_SendErrorResponse(BootErrorCode_t errorCode) {
     const char *error_msg = GetErrorMessage(errorCode);
+    boot_status.lastError = (uint8_t)errorCode;
     uint16_t error_msg_len = strlen(error_msg);
     Boot_SendFrame(CMD_ERROR_RESPONSE, (uint8_t *)error_msg, error_msg_len);
 }
 
-void Boot_ReceiveCommand(uint8_t received_byte) {
-    // 命令接收处理实现
-    command_parse_result = command_process_byte(received_byte);
+/**
+ * @brief 发送状态响应，擦写和校验进度直接取自正在运行的任务
+ */
+static void Boot_SendStatusResponse(void) {
+    BOOT_StatusInfo_t status;
 
-    switch (command_parse_result) {
-    case PARSE_SUCCESS:
-        if (command_get_frame(&current_frame)) {
-            is_recived = true;
-            bootErrorCode = ERROR_CODE_NO_ERROR;
-        }
-        break;
-    case PARSE_ERROR_HEADER:
-        bootErrorCode = ERROR_CODE_PARSE_FAILED;
-        is_recived = false;
-        break;
-    case PARSE_ERROR_INVALID_CMD:
-        bootErrorCode = ERROR_CODE_PARSE_UNKNOWN_CMD;
-        is_recived = false;
-        break;
-    case PARSE_ERROR_LENGTH:
-        bootErrorCode = ERROR_CODE_PARSE_ERROR_LENGTH;
-        is_recived = false;
-        break;
-    case PARSE_ERROR_CHECKSUM:
-        bootErrorCode = ERROR_CODE_PARSE_ERROR_CHECKSUM;
-        is_recived = false;
-        break;
-    case PARSE_INCOMPLETE:
-        // 正常状态，不做处理
-        break;
-    default:
-        bootErrorCode = ERROR_CODE_NO_ERROR;
-        is_recived = false;
-        break;
+    status.statusInfo = boot_status;
+    status.statusInfo.state = (uint8_t)current_boot_state;
+    status.statusInfo.operation = BOOT_OPERATION_IDLE;
+    if (Boot_TaskIsRunning(&upload_task)) {
+        status.statusInfo.operation = slot_job.data == NULL
+                                          ? BOOT_OPERATION_ERASE
+                                          : BOOT_OPERATION_PROGRAM;
+    } else if (Boot_TaskIsRunning(&verify_task)) {
+        status.statusInfo.operation = BOOT_OPERATION_VERIFY;
+    } else if (Boot_TaskIsRunning(&block_crc_task)) {
+        status.statusInfo.operation = BOOT_OPERATION_BLOCK_CRC;
     }
-}
\ No newline at end of file
+    status.statusInfo.queueDepth = (uint8_t)Boot_EventCount();
+    status.statusInfo.eventsDropped = Boot_EventDropped();
+    status.statusInfo.bytesVerified = verify_job.offset;
+    status.statusInfo.uptimeUs = Boot_GetUs();
+    status.statusInfo.verifyUs = Boot_ImageGetLastReport()->elapsedUs;
+
+    Boot_SendFrame(CMD_STATUS, status.rawData, sizeof(BOOT_StatusInfo_t));
+}
+
+void Boot_ReceiveCommand(uint8_t received_byte) {
+    Boot_TransportReceive(&legacy_transport, &received_byte, 1);
+}
+
+void Boot_ReceiveData(const uint8_t *data, uint16_t length) {
+    Boot_TransportReceive(&legacy_transport, data, length);
+}
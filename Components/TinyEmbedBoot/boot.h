@@ -2,6 +2,8 @@
 #define _BOOT_H_
 #include "boot_cfg.h"
 // #include "boot_cmd.h"
+#include "boot_event.h"
+#include "boot_resume.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -47,6 +49,19 @@ extern "C" {
 #define APPLICATION_START_ADDRESS BOOT_APP_ADDRESS
 #define FLASH_END_ADDRESS BOOT_FLASH_END_ADDRESS
 
+// 跳转app时保留给app的外设配置，可按位组合
+#define BOOT_HANDOFF_NONE 0x00
+#define BOOT_HANDOFF_CLOCK 0x01     // 保留时钟树，app可跳过SystemClock_Config
+#define BOOT_HANDOFF_QSPI_MMAP 0x02 // 保留QSPI内存映射模式，app可直接读取
+// 共享RAM中的交接标志，高16位为标识，低16位为BOOT_HANDOFF_xxx
+#define BOOT_HANDOFF_TAG 0xB0E70000
+#define BOOT_HANDOFF_TAG_MASK 0xFFFF0000
+#define BOOT_HANDOFF_ADDRESS (BOOT_SHARED_RAM_ADDRESS + 12)
+#if BOOT_RESUME_PERSIST
+_Static_assert(BOOT_HANDOFF_ADDRESS + 4 <= BOOT_RESUME_RAM_ADDRESS,
+               "Shared RAM words must end before BOOT_RESUME_RAM_ADDRESS");
+#endif
+
 // 函数指针，用于复位函数实例化
 typedef void (*FunctionPointer)(void);
 typedef struct {
@@ -81,6 +96,16 @@ typedef struct {
     uint32_t appAddr;
     uint32_t firmware_packet;
     char bootVersion[DEVICE_INFO_BOOT_VERSION_LENGTH];
+    uint8_t frameCheck; // 本次会话协商的帧校验方式，见frame_check_t
+    uint8_t reserved[3];
+    // 可续传的上传：sessionId不为0时只需补发missing中的包，之后CMD_VERIFY；
+    // missingNum等于BOOT_RESUME_MAX_RANGES时可能还有更多，补发后再次查询
+    uint32_t sessionId;      // 上传会话，0为没有可续传的会话
+    uint32_t packetTotalNum; // 会话的总包数
+    uint32_t packetsDone;    // 已写入的包数
+    uint8_t missingNum;      // missing中有效的范围个数
+    uint8_t reserved2[3];
+    BootResumeRange_t missing[BOOT_RESUME_MAX_RANGES]; // 缺失的包，按包号排列
 } ALIGNED(1) deviceInfo_t;
 
 // 固件结构体
@@ -90,6 +115,72 @@ typedef struct {
     uint32_t packetCRC32;
     uint8_t firmware[DEVICE_INFO_FIRMWARE_PACKET_SIZE];
 } ALIGNED(1) firmwareInfo_t;
+_Static_assert(sizeof(firmwareInfo_t) == BOOT_FIRMWARE_PACKET_HEADER_SIZE +
+                                             DEVICE_INFO_FIRMWARE_PACKET_SIZE,
+               "firmwareInfo_t must be the packet header followed by the data");
+_Static_assert(sizeof(firmwareInfo_t) <= BOOT_FRAME_DATA_SIZE,
+               "A firmware packet must fit in BOOT_FRAME_DATA_SIZE");
+
+// 固件记录标志
+// 只擦除[address, address + length)，不带数据
+#define BOOT_RECORD_FLAG_ERASE 0x01
+
+// 固件记录结构体（CMD_UPLOAD_RECORD），头部与固件包同为12字节
+// 同一次升级的第一条记录作废候选槽，之后每条记录只擦除自己覆盖的块，
+// 没有记录的块保持原内容；需要读出0xFF的空隙用BOOT_RECORD_FLAG_ERASE记录擦除。
+// address和length不要求对齐，不足闪存字的部分经写合并缓冲凑满后写入，
+// 记录之间不能重叠
+typedef struct {
+    uint32_t address; // 槽内偏移，即链接地址减去appAddr
+    uint32_t length;  // 数据长度，不超过协商的包大小；只擦除时为擦除长度
+    uint32_t flags;   // BOOT_RECORD_FLAG_xxx
+    uint8_t data[DEVICE_INFO_FIRMWARE_PACKET_SIZE];
+} ALIGNED(1) firmwareRecord_t;
+_Static_assert(sizeof(firmwareRecord_t) == sizeof(firmwareInfo_t),
+               "firmwareRecord_t must share the packet header size");
+
+// 正在进行的擦写或校验
+typedef enum {
+    BOOT_OPERATION_IDLE = 0,
+    BOOT_OPERATION_ERASE = 1,
+    BOOT_OPERATION_PROGRAM = 2,
+    BOOT_OPERATION_VERIFY = 3,
+    BOOT_OPERATION_BLOCK_CRC = 4,
+} BootOperation_t;
+
+// 状态信息结构体（1字节对齐），CMD_STATUS的应答数据，小端序
+typedef struct {
+    uint8_t state;            // BootState_t
+    uint8_t operation;        // BootOperation_t
+    uint8_t lastError;        // 最近一次上报给上位机的错误码
+    uint8_t queueDepth;       // 事件队列中待处理的事件数
+    uint32_t eventsDropped;   // 队列满丢弃的事件数
+    uint32_t bytesReceived;   // 本次上传收到的固件字节数
+    uint32_t bytesProgrammed; // 本次上传已写入flash的字节数
+    uint32_t bytesErased;     // 本次上传已擦除的字节数
+    uint32_t sectorsErased;   // 本次上传已擦除的块数
+    uint32_t bytesVerified;   // 整镜像校验已计算的字节数
+    uint32_t uptimeUs;        // 上电后的时间，微秒，约71分钟回绕
+    uint32_t operationUs;     // 当前或最近一次擦写、校验的耗时，微秒
+    uint32_t verifyUs;        // 最近一次整镜像CRC计算的耗时，微秒
+    uint32_t packetsRepeated; // 本次上传中重发、未写flash直接应答的包数
+} ALIGNED(1) statusInfo_t;
+
+// 块CRC结构体（1字节对齐），CMD_BLOCK_CRC的应答数据，小端序
+// 请求数据为firstBlock和blockNum（各4字节，可省略，默认从0开始尽量多）。
+// 块从候选槽起始地址按blockSize划分，最后一块可能不满；CRC算法与
+// FRAME_CHECK_CRC32相同。上位机对比新镜像后只用CMD_UPLOAD_RECORD发送
+// 不同的块，其余块保持原内容
+typedef struct {
+    uint32_t slotAddress; // 候选槽执行地址
+    uint32_t blockSize;   // 块大小：QSPI为4KB扇区，片内flash为扇区
+    uint32_t blockTotal;  // 槽的总块数
+    uint32_t firstBlock;  // 本次应答的第一块
+    uint32_t blockNum;    // 本次应答的块数
+    uint32_t crc32[BOOT_BLOCK_CRC_MAX_NUMS];
+} ALIGNED(1) blockCrcInfo_t;
+_Static_assert(sizeof(blockCrcInfo_t) <= BOOT_FRAME_DATA_SIZE,
+               "BOOT_BLOCK_CRC_MAX_NUMS CRCs must fit in BOOT_FRAME_DATA_SIZE");
 
 // 设备信息联合体，用于打包
 typedef union {
@@ -97,11 +188,42 @@ typedef union {
     deviceInfo_t deviceInfo;
 } BOOT_DeviceInfo_t;
 
+// 块CRC联合体，用于打包
+typedef union {
+    uint8_t rawData[sizeof(blockCrcInfo_t)];
+    blockCrcInfo_t blockCrcInfo;
+} BOOT_BlockCrcInfo_t;
+
+// 状态信息联合体，用于打包
+typedef union {
+    uint8_t rawData[sizeof(statusInfo_t)];
+    statusInfo_t statusInfo;
+} BOOT_StatusInfo_t;
+
 // 固件联合体，用于读取
 typedef union {
     uint8_t rawDate[sizeof(firmwareInfo_t)];
     firmwareInfo_t firmwareInfo;
+    firmwareRecord_t firmwareRecord;
 } BOOT_FirmwareInfo_t;
+/**
+ * @brief 读取DWT周期计数器，Boot_Init中使能
+ */
+static inline uint32_t Boot_GetCycles(void) { return DWT->CYCCNT; }
+
+/**
+ * @brief 上电后的微秒数，由SysTick毫秒计数和当前计数值组成，约71分钟回绕
+ * @details DWT周期计数器400MHz下约10秒回绕，不适合计量整片擦除这样的长操作
+ */
+uint32_t Boot_GetUs(void);
+
+/**
+ * @brief 周期数转换为微秒
+ */
+static inline uint32_t Boot_CyclesToUs(uint32_t cycles) {
+    return (uint32_t)(((uint64_t)cycles * 1000000U) / SystemCoreClock);
+}
+
 /**
  * @brief 获取错误信息
  * @param errorCode 错误码
@@ -123,21 +245,67 @@ void Boot_Init(Boot_SendData_Func send_func);
  */
 void Boot_ProcessStateMachine(void);
 
+/**
+ * @brief 事件队列为空且没有任务主动让出，可以睡眠到下一个中断
+ * @details 收到命令帧、解析出错、按键和超时都由中断投递到事件队列，
+ *          等待硬件的任务由完成中断或SysTick唤醒；
+ *          调用者应在关中断后检查再执行WFI，避免检查后到来的事件被错过
+ * @return true 可以睡眠
+ */
+bool Boot_IsIdle(void);
+
+/**
+ * @brief 是否有擦写或校验任务在运行
+ * @details 运行期间只立即处理CMD_ACK和CMD_ABORT，其他命令帧等任务结束后处理
+ */
+bool Boot_IsFlashBusy(void);
+
+/**
+ * @brief 在SysTick中断中调用，启动模式等待超时时投递BOOT_EVENT_TIMEOUT
+ */
+void Boot_TickHandler(void);
+
 /**
  * @brief 验证固件是否合法
  * @return 0不合法 1合法
  */
 uint8_t Boot_IsApplicationValid(void);
 
+// 外设反初始化函数类型，handoff为本次跳转保留的外设配置
+typedef void (*Boot_DeInit_Func)(uint32_t handoff);
+
+/**
+ * @brief 注册跳转app前的外设反初始化函数
+ * @details 按注册的逆序调用，先初始化的外设（如MPU）最后关闭
+ * @param deinit_func 反初始化函数
+ * @return 注册成功返回true，超过BOOT_DEINIT_MAX_NUMS返回false
+ */
+bool Boot_RegisterDeInit(Boot_DeInit_Func deinit_func);
+
+/**
+ * @brief 设置跳转app时保留的外设配置
+ * @param handoff BOOT_HANDOFF_xxx按位组合
+ */
+void Boot_SetHandoff(uint32_t handoff);
+
+/**
+ * @brief 由app调用，读取boot保留的外设配置
+ * @return BOOT_HANDOFF_xxx按位组合，不是从boot跳转过来时返回BOOT_HANDOFF_NONE
+ */
+uint32_t Boot_GetHandoff(void);
+
 /**
  * @brief 跳转到固件
+ * @details 依次调用已注册的反初始化函数，关闭SysTick和全部NVIC中断，
+ *          未保留时钟树时复位RCC
  */
 void Boot_JumpToApplication(void);
 /**
- * @brief 进入BootLoader模式，解析来自上位机的指令，进行固件升级等操作
+ * @brief 进入BootLoader模式，处理一个事件：执行上位机的指令、上报解析错误等
+ * @param event 事件队列中取出的事件，BOOT_EVENT_NONE表示没有事件
  * @return BootState_t 返回boot状态，用于跳转app
  */
-BootState_t Boot_EnterBootloaderMode(void);
+BootState_t Boot_EnterBootloaderMode(const BootEvent_t *event);
 
 /**
  * @brief 处理接收数据。在数据接收回调函数中调用
@@ -145,6 +313,13 @@ BootState_t Boot_EnterBootloaderMode(void);
  */
 void Boot_ReceiveCommand(uint8_t received_byte);
 
+/**
+ * @brief 按数据块处理接收数据。用于DMA等一次收到多个字节的传输
+ * @param data 数据
+ * @param length 数据长度
+ */
+void Boot_ReceiveData(const uint8_t *data, uint16_t length);
+
 #ifdef __cplusplus
 }
 #endif
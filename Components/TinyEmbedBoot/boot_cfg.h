@@ -5,6 +5,9 @@
 // 基础配置，可自定义
 // app加载地址
 #define BOOT_APP_ADDRESS (0x08010000)
+// 1：app与boot共用片内flash扇区（H750只有一个128KB扇区），A槽为烧录器写入的
+// 出厂固件，boot不擦写；0：app必须从扇区边界开始
+#define BOOT_APP_SHARE_SECTOR 1
 // 固件分包大小
 #define BOOT_FIRMWARE_PACKET_SIZE (512)
 // 命令帧中数据的大小
@@ -13,6 +16,9 @@
 #define BOOT_FLASH_END_ADDRESS FLASH_END // 这里使用的hal库定义
 // flash大小
 #define BOOT_FLASH_SIZE FLASH_SIZE // 这里使用的hal库定义
+// 1：CRC32帧校验使用片上CRC单元；0：使用slice-by-8查表
+// 主机测试定义BOOT_HOST_TEST（见test/CMakeLists.txt），不访问外设，总是使用查表
+#define BOOT_FRAME_CRC32_HW 1
 // 设备名称
 #define BOOT_DEVICE_NAME "STM32H750"
 // 上电等待时间选择启动模式，毫秒
@@ -20,4 +26,111 @@
 // boot版本
 #define BOOT_VERSION "v0.0.1"
 
+// A/B双槽配置
+// A槽：片内flash，即原app加载地址，存放出厂固件
+#define BOOT_SLOT_A_ADDRESS BOOT_APP_ADDRESS
+#define BOOT_SLOT_A_SIZE (BOOT_FLASH_END_ADDRESS + 1 - BOOT_SLOT_A_ADDRESS)
+// B槽：QSPI flash中的偏移和大小，内存映射后原地执行
+#define BOOT_SLOT_B_QSPI_OFFSET (0x00000000)
+#define BOOT_SLOT_B_SIZE (0x00400000)
+// 槽元数据在QSPI flash中的偏移，占用两个4KB扇区交替写入
+#define BOOT_SLOT_META_QSPI_OFFSET (0x007FE000)
+// 未确认的新固件最多启动次数，超过后回滚
+#define BOOT_SLOT_MAX_BOOT_ATTEMPTS 3
+// boot与app共享的数据区（备份SRAM，复位后保持）
+#define BOOT_SHARED_RAM_ADDRESS D3_BKPSRAM_BASE
+#define BOOT_SHARED_RAM_SIZE 0x1000
+
+// 可注册的传输通道个数（USB CDC、UART等）
+#define BOOT_TRANSPORT_MAX_NUMS 4
+// 中断到主循环的事件队列长度，必须是2的幂
+#define BOOT_EVENT_QUEUE_SIZE 16
+// 已解析、等待主循环处理的命令帧槽个数，每个槽占一个完整命令帧
+#define BOOT_FRAME_SLOT_NUMS 2
+// 发送帧缓冲池，发送完成后由通道释放，应答可以连续发出而不等待上一帧
+// 小缓冲用于ACK、错误信息、状态和设备信息等短应答，大缓冲为一个完整命令帧
+#define BOOT_TX_SMALL_SIZE 128
+#define BOOT_TX_SMALL_NUMS 4
+#define BOOT_TX_LARGE_NUMS 1
+// 发送缓冲池用完时等待通道释放的最长时间
+#define BOOT_TX_ALLOC_TIMEOUT_MS 50
+// 可同时运行的协作式任务个数
+#define BOOT_TASK_MAX_NUMS 8
+// 擦写任务每步写入片内flash的字节数，32字节闪存字的整数倍
+#define BOOT_SLOT_WRITE_STEP_SIZE 256
+// 校验任务每步计算CRC的字节数
+#define BOOT_IMAGE_VERIFY_STEP_SIZE 0x4000
+// 热路径函数（帧解析、帧校验、事件队列、擦写和校验步进）放在ITCM中零等待执行，
+// 启动代码从flash拷贝。定义为空则留在flash，主机测试时为空
+#if defined(__arm__)
+#define BOOT_ITCM __attribute__((section(".itcm_text")))
+#else
+#define BOOT_ITCM
+#endif
+
+// 断点续传：按包号记录已写入的包，USB断开重连后从缺失的包继续
+// 可续传的最大包数，位图占BOOT_RESUME_MAX_PACKETS/8字节
+#define BOOT_RESUME_MAX_PACKETS 8192
+// CMD_ENTER_BOOT应答中最多列出的缺失范围个数
+#define BOOT_RESUME_MAX_RANGES 8
+// 1：进度保存在备份SRAM中，复位后仍可续传；0：只保存在RAM中
+#define BOOT_RESUME_PERSIST 1
+// 进度在备份SRAM中的地址，前面是槽确认请求、校验计数和交接标志
+#define BOOT_RESUME_RAM_ADDRESS (BOOT_SHARED_RAM_ADDRESS + 0x40)
+// 记录最近写入的包号和数据CRC的个数，ACK丢失后重发的包直接应答
+#define BOOT_UPLOAD_HISTORY_NUMS 4
+// CMD_BLOCK_CRC一次应答最多返回的块CRC个数
+#define BOOT_BLOCK_CRC_MAX_NUMS 128
+
+// 跳转app前可注册的外设反初始化函数个数
+#define BOOT_DEINIT_MAX_NUMS 8
+// 默认保留给app的外设配置，见boot.h中的BOOT_HANDOFF_xxx
+#define BOOT_HANDOFF_DEFAULT BOOT_HANDOFF_NONE
+
+// 固件头配置
+// 固件头在镜像内的偏移，紧跟中断向量表（166个向量，0x298字节）
+#define BOOT_IMAGE_HEADER_OFFSET (0x298)
+// 1：没有固件头的镜像视为无效；0：无固件头时只做向量表检查
+#define BOOT_IMAGE_REQUIRE_HEADER 1
+// 整镜像CRC校验周期：校验令牌有效时，每隔这么多次复位才重新全量校验一次，
+// 0表示每次启动都全量校验。计数保存在备份SRAM中，掉电且无VBAT时从0重新计数
+#define BOOT_IMAGE_VERIFY_INTERVAL 64
+
+// 派生常量，由上面的配置计算，不需要修改
+// 片内flash闪存字（256位），编程的最小单位
+#define BOOT_FLASH_WORD_SIZE (FLASH_NB_32BITWORD_IN_FLASHWORD * 4U)
+// 固件包信息（包号、总包数、CRC32）的字节数
+#define BOOT_FIRMWARE_PACKET_HEADER_SIZE 12U
+// app在所在片内flash扇区内的偏移
+#define BOOT_APP_SECTOR_OFFSET                                                 \
+    ((BOOT_APP_ADDRESS - FLASH_BANK1_BASE) % FLASH_SECTOR_SIZE)
+// VTOR要求向量表按其大小向上取2的幂对齐，166个向量为1KB
+#define BOOT_VECTOR_TABLE_ALIGN 0x400U
+
+// 配置检查，配置错误时编译失败，运行时不再逐包检查；
+// 与结构体大小相关的检查用_Static_assert放在结构体定义旁边
+#if BOOT_FIRMWARE_PACKET_SIZE <= 0 ||                                          \
+    (BOOT_FIRMWARE_PACKET_SIZE % BOOT_FLASH_WORD_SIZE) != 0
+#error "BOOT_FIRMWARE_PACKET_SIZE must be a non-zero multiple of the 32-byte flash word"
+#endif
+#if BOOT_FRAME_DATA_SIZE > 0xFFFF
+#error "BOOT_FRAME_DATA_SIZE must fit the 16-bit frame length field"
+#endif
+#if BOOT_APP_ADDRESS <= FLASH_BANK1_BASE || BOOT_APP_ADDRESS > BOOT_FLASH_END_ADDRESS
+#error "BOOT_APP_ADDRESS must lie inside internal flash, after the bootloader"
+#endif
+#if (BOOT_APP_ADDRESS % BOOT_VECTOR_TABLE_ALIGN) != 0
+#error "BOOT_APP_ADDRESS must be 1 KB aligned for VTOR"
+#endif
+#if BOOT_APP_SECTOR_OFFSET != 0 && !BOOT_APP_SHARE_SECTOR
+#error "BOOT_APP_ADDRESS must start a flash sector unless BOOT_APP_SHARE_SECTOR is 1"
+#endif
+#if BOOT_SLOT_B_SIZE / BOOT_FIRMWARE_PACKET_SIZE > BOOT_RESUME_MAX_PACKETS ||   \
+    BOOT_SLOT_A_SIZE / BOOT_FIRMWARE_PACKET_SIZE > BOOT_RESUME_MAX_PACKETS
+#error "BOOT_RESUME_MAX_PACKETS must cover a full slot at the default packet size"
+#endif
+#if (BOOT_SLOT_WRITE_STEP_SIZE % BOOT_FLASH_WORD_SIZE) != 0
+#error "BOOT_SLOT_WRITE_STEP_SIZE must be a multiple of the 32-byte flash word"
+#endif
+
 #endif
\ No newline at end of file
@@ -1,63 +1,369 @@
 #include "boot_cmd.h"
 #include "string.h"
 
-static rx_state_t rx_state = RX_STATE_HEADER1;
-static command_frame_t current_frame;
-static uint16_t data_recived_size = 0;
-static bool frame_ready = false;
+// 命令字和长度在帧缓冲中的大小，数据紧随其后
+#define PARSER_HEADER_SIZE (FRAME_COMMAND_SIZE + FRAME_DATA_LENGTH_INFO)
 
-static void clear_command_frame(command_frame_t *frame) {
-    memset(frame, 0, sizeof(command_frame_t));
-}
+// 不带实例接口使用的默认解析器
+static command_parser_t default_parser;
+static uint8_t default_parser_buffer[COMMAND_PARSER_BUFFER_SIZE(FRAME_DATA_SIZE)];
 /**
  * @brief 计算校验和
+ * @details 按字读取，一个字的4个字节分两组累加到两个16位通道（SWAR），
+ *          每128个字折叠一次，通道不会溢出
  * @param data 从命令字到数据全部的数据
  * @param length 长度为命令(1byte)+数据长度信息(2byte)+实际数据长度
  * @return
  */
-static uint8_t calculate_checksum(uint8_t *data, uint16_t length) {
-    uint8_t sum = 0;
+BOOT_ITCM static uint8_t calculate_checksum(const uint8_t *data,
+                                            uint32_t length) {
+    uint32_t sum = 0;
 
-    for (uint16_t i = 0; i < length; i++) {
-        sum += data[i];
+    // 头部非对齐字节
+    while (length > 0 && ((uintptr_t)data & 0x3) != 0) {
+        sum += *data++;
+        length--;
+    }
+    while (length >= 4) {
+        uint32_t words = length >> 2;
+        uint32_t lanes = 0;
+        if (words > 128) {
+            words = 128;
+        }
+        length -= words << 2;
+        while (words--) {
+            uint32_t word;
+            memcpy(&word, data, sizeof(word));
+            lanes += (word & 0x00FF00FFU) + ((word >> 8) & 0x00FF00FFU);
+            data += 4;
+        }
+        sum += (lanes & 0xFFFFU) + (lanes >> 16);
+    }
+    // 尾部剩余字节
+    while (length--) {
+        sum += *data++;
     }
     return (uint8_t)~sum;
 }
+
+// CRC-16/CCITT-FALSE查表，多项式0x1021
+static const uint16_t crc16_table[256] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0,
+};
+
+BOOT_ITCM static uint16_t calculate_crc16(const uint8_t *data,
+                                          uint32_t length) {
+    uint16_t crc = 0xFFFF;
+    while (length--) {
+        crc = (uint16_t)(crc << 8) ^ crc16_table[(uint8_t)(crc >> 8) ^ *data++];
+    }
+    return crc;
+}
+
+#if BOOT_FRAME_CRC32_HW && !defined(BOOT_HOST_TEST)
+/**
+ * @brief 用片上CRC单元计算CRC-32/MPEG-2（MX_CRC_Init的默认配置）
+ * @details 可能在中断中打断主循环的镜像校验，先保存CRC单元的中间结果，
+ *          算完后通过INIT寄存器恢复
+ */
+BOOT_ITCM static uint32_t calculate_crc32(const uint8_t *data,
+                                          uint32_t length) {
+    const uint8_t *end = data + length;
+    uint32_t saved = CRC->DR;
+    uint32_t init = CRC->INIT;
+
+    CRC->CR |= CRC_CR_RESET;
+    while (data < end && ((uintptr_t)data & 0x3) != 0) {
+        *(__IO uint8_t *)&CRC->DR = *data++;
+    }
+    while (end - data >= 4) {
+        CRC->DR = __REV(*(const uint32_t *)data);
+        data += 4;
+    }
+    while (data < end) {
+        *(__IO uint8_t *)&CRC->DR = *data++;
+    }
+    uint32_t crc = CRC->DR;
+
+    CRC->INIT = saved;
+    CRC->CR |= CRC_CR_RESET;
+    CRC->INIT = init;
+    return crc;
+}
+#else
+// CRC-32/MPEG-2的slice-by-8查表，第k张表为字节后跟k个0字节的CRC，首次使用时生成
+static uint32_t crc32_table[8][256];
+static bool crc32_table_ready = false;
+
+static void crc32_make_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i << 24;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80000000U) ? (crc << 1) ^ 0x04C11DB7U : crc << 1;
+        }
+        crc32_table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (uint8_t k = 1; k < 8; k++) {
+            uint32_t prev = crc32_table[k - 1][i];
+            crc32_table[k][i] = (prev << 8) ^ crc32_table[0][prev >> 24];
+        }
+    }
+    crc32_table_ready = true;
+}
+
+BOOT_ITCM static uint32_t calculate_crc32(const uint8_t *data,
+                                          uint32_t length) {
+    uint32_t crc = 0xFFFFFFFFU;
+    if (!crc32_table_ready) {
+        crc32_make_table();
+    }
+    // 每次处理8字节，前4字节与当前CRC合并
+    while (length >= 8) {
+        uint32_t high = crc ^ ((uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 |
+                               (uint32_t)data[2] << 8 | data[3]);
+        crc = crc32_table[7][high >> 24] ^ crc32_table[6][(high >> 16) & 0xFF] ^
+              crc32_table[5][(high >> 8) & 0xFF] ^ crc32_table[4][high & 0xFF] ^
+              crc32_table[3][data[4]] ^ crc32_table[2][data[5]] ^
+              crc32_table[1][data[6]] ^ crc32_table[0][data[7]];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = (crc << 8) ^ crc32_table[0][(crc >> 24) ^ *data++];
+    }
+    return crc;
+}
+#endif
+
+uint8_t command_check_size(frame_check_t mode) {
+    switch (mode) {
+    case FRAME_CHECK_CRC16:
+        return 2;
+    case FRAME_CHECK_CRC32:
+        return 4;
+    default:
+        return FRAMR_CHECK_SUM_SIZE;
+    }
+}
+
+frame_check_t command_frame_check(command_type_t cmd, frame_check_t mode) {
+    if (cmd == CMD_ENTER_BOOT || mode >= FRAME_CHECK_NUMS) {
+        return FRAME_CHECK_SUM8;
+    }
+    return mode;
+}
+
+BOOT_ITCM uint32_t command_calc_check(frame_check_t mode, const uint8_t *data,
+                                      uint32_t length) {
+    switch (mode) {
+    case FRAME_CHECK_CRC16:
+        return calculate_crc16(data, length);
+    case FRAME_CHECK_CRC32:
+        return calculate_crc32(data, length);
+    default:
+        return calculate_checksum(data, length);
+    }
+}
 /**
  * @brief 验证命令是否合法
  * @param cmd 命令字
  * @return
  */
-static bool is_valid_command(command_type_t cmd) {
+BOOT_ITCM static bool is_valid_command(command_type_t cmd) {
     return ((cmd > CMD_VALID_START) && (cmd < CMD_VALID_END));
 }
 
-void command_parser_init(void) {
-    rx_state = RX_STATE_HEADER1;
-    clear_command_frame(&current_frame);
-    data_recived_size = 0;
-    frame_ready = false;
+BOOT_ITCM static bool is_valid_length(const command_parser_t *parser,
+                                      uint16_t length) {
+    return length == 0 ||
+           (length < FRAME_DATA_SIZE && length <= parser->max_data_length);
 }
 
-rx_state_t get_rx_state(void) { return rx_state; }
+/**
+ * @brief 出错后在已缓存的字节中重新查找帧头
+ * @details 错误帧的帧头之后的字节（命令字、长度、数据、校验）都在帧缓冲中，
+ *          其中可能包含真正的帧头，例如长度字节出错时吞掉了后面的帧。
+ *          找到完整且校验正确的帧时直接返回成功，之后的字节丢弃；
+ *          找到不完整的候选帧时把它移到缓冲开头，从对应状态继续接收
+ * @param parser 解析器
+ * @param length 帧缓冲中已缓存的字节数
+ * @return 找到完整帧返回PARSE_SUCCESS，否则返回PARSE_INCOMPLETE
+ */
+BOOT_ITCM static parse_result_t command_parser_resync(command_parser_t *parser,
+                                                      uint16_t length) {
+    uint8_t *src = parser->buffer;
 
-parse_result_t command_process_byte(uint8_t byte) {
+    parser->rx_state = RX_STATE_HEADER1;
+    for (uint16_t pos = 0; pos < length; pos++) {
+        if (src[pos] != FRAME_HEADER1) {
+            continue;
+        }
+        if (pos + 1 == length) {
+            parser->rx_state = RX_STATE_HEADER2;
+            return PARSE_INCOMPLETE;
+        }
+        if (src[pos + 1] != FRAME_HEADER2) {
+            continue;
+        }
+
+        // 检查候选帧已经收到的部分
+        uint16_t start = pos + 2;
+        uint16_t count = length - start;
+        uint16_t data_length = 0;
+        frame_check_t mode = parser->check_mode;
+        if (count >= 1) {
+            if (!is_valid_command((command_type_t)src[start])) {
+                continue;
+            }
+            mode = command_frame_check((command_type_t)src[start], mode);
+        }
+        if (count >= PARSER_HEADER_SIZE) {
+            data_length = src[start + 1] | (src[start + 2] << 8);
+            if (!is_valid_length(parser, data_length)) {
+                continue;
+            }
+        }
+        uint16_t frame_length = PARSER_HEADER_SIZE + data_length;
+        uint8_t check_size = command_check_size(mode);
+
+        // 候选帧完整，校验通过才接受
+        if (count >= PARSER_HEADER_SIZE &&
+            count >= frame_length + check_size) {
+            uint32_t checksum = 0;
+            for (uint8_t i = 0; i < check_size; i++) {
+                checksum |= (uint32_t)src[start + frame_length + i] << (8 * i);
+            }
+            if (command_calc_check(mode, &src[start], frame_length) !=
+                checksum) {
+                continue;
+            }
+            memmove(parser->buffer, &src[start], frame_length);
+            parser->data_length = data_length;
+            parser->checksum = checksum;
+            parser->frame_ready = true;
+            return PARSE_SUCCESS;
+        }
+
+        // 候选帧不完整，移到缓冲开头继续接收
+        memmove(parser->buffer, &src[start], count);
+        parser->frame_ready = false;
+        parser->data_length = data_length;
+        parser->data_recived_size = 0;
+        parser->check_recived_size = 0;
+        parser->checksum = 0;
+        if (count == 0) {
+            parser->rx_state = RX_STATE_CMD;
+        } else if (count == 1) {
+            parser->rx_state = RX_STATE_LEN_LOW;
+        } else if (count == 2) {
+            parser->data_length = parser->buffer[1];
+            parser->rx_state = RX_STATE_LEN_HIGH;
+        } else if (count < frame_length) {
+            parser->data_recived_size = count - PARSER_HEADER_SIZE;
+            parser->rx_state = RX_STATE_DATA;
+        } else {
+            parser->data_recived_size = data_length;
+            parser->check_recived_size = (uint8_t)(count - frame_length);
+            for (uint8_t i = 0; i < parser->check_recived_size; i++) {
+                parser->checksum |= (uint32_t)parser->buffer[frame_length + i]
+                                    << (8 * i);
+            }
+            parser->rx_state = RX_STATE_CHECKSUM;
+        }
+        return PARSE_INCOMPLETE;
+    }
+    return PARSE_INCOMPLETE;
+}
+
+void command_parser_setup(command_parser_t *parser, uint8_t *buffer,
+                          uint16_t buffer_size) {
+    uint16_t max_data_length = 0;
+    if (buffer_size > PARSER_HEADER_SIZE + FRAME_CHECK_MAX_SIZE) {
+        max_data_length = buffer_size - PARSER_HEADER_SIZE - FRAME_CHECK_MAX_SIZE;
+    }
+    parser->buffer = buffer;
+    parser->max_data_length =
+        max_data_length < FRAME_DATA_SIZE ? max_data_length : FRAME_DATA_SIZE;
+    parser->check_mode = FRAME_CHECK_SUM8;
+    command_parser_reset(parser);
+}
+
+void command_parser_limit(command_parser_t *parser, uint16_t max_data_length) {
+    if (max_data_length < parser->max_data_length) {
+        parser->max_data_length = max_data_length;
+    }
+}
+
+void command_parser_reset(command_parser_t *parser) {
+    parser->rx_state = RX_STATE_HEADER1;
+    parser->data_recived_size = 0;
+    parser->data_length = 0;
+    parser->checksum = 0;
+    parser->check_recived_size = 0;
+    parser->frame_ready = false;
+}
+
+void command_parser_set_check(command_parser_t *parser, frame_check_t mode) {
+    parser->check_mode = mode < FRAME_CHECK_NUMS ? mode : FRAME_CHECK_SUM8;
+}
+
+rx_state_t command_parser_get_state(const command_parser_t *parser) {
+    return parser->rx_state;
+}
+
+BOOT_ITCM parse_result_t command_parser_process_byte(command_parser_t *parser,
+                                                     uint8_t byte) {
     parse_result_t ret;
-    switch (rx_state) {
+    switch (parser->rx_state) {
     case RX_STATE_HEADER1:
         if (byte == FRAME_HEADER1) {
-            rx_state = RX_STATE_HEADER2;
+            parser->rx_state = RX_STATE_HEADER2;
         } else {
-            rx_state = RX_STATE_HEADER1;
+            parser->rx_state = RX_STATE_HEADER1;
         }
         ret = PARSE_INCOMPLETE;
         break;
 
     case RX_STATE_HEADER2:
         if (byte == FRAME_HEADER2) {
-            rx_state = RX_STATE_CMD;
+            parser->rx_state = RX_STATE_CMD;
+        } else if (byte == FRAME_HEADER1) {
+            // AA AA 55：当前字节可能是真正的帧头，保持在等待第二个帧头
+            parser->rx_state = RX_STATE_HEADER2;
         } else {
-            rx_state = RX_STATE_HEADER1;
+            parser->rx_state = RX_STATE_HEADER1;
             return PARSE_ERROR_HEADER;
         }
         ret = PARSE_INCOMPLETE;
@@ -65,93 +371,129 @@ parse_result_t command_process_byte(uint8_t byte) {
 
     case RX_STATE_CMD:
         if (is_valid_command((command_type_t)byte)) {
-            current_frame.command = (command_type_t)byte;
-            rx_state = RX_STATE_LEN_LOW;
+            // 新帧覆盖帧缓冲，未取出的旧帧作废
+            parser->frame_ready = false;
+            parser->buffer[0] = byte;
+            parser->rx_state = RX_STATE_LEN_LOW;
             ret = PARSE_INCOMPLETE;
         } else {
-            rx_state = RX_STATE_HEADER1;
+            // 命令字本身可能是下一帧的帧头
+            parser->rx_state =
+                byte == FRAME_HEADER1 ? RX_STATE_HEADER2 : RX_STATE_HEADER1;
             ret = PARSE_ERROR_INVALID_CMD;
         }
         break;
 
     case RX_STATE_LEN_LOW:
-        current_frame.data_length = byte;
-        rx_state = RX_STATE_LEN_HIGH;
+        parser->data_length = byte;
+        parser->buffer[1] = byte;
+        parser->rx_state = RX_STATE_LEN_HIGH;
         ret = PARSE_INCOMPLETE;
         break;
 
     case RX_STATE_LEN_HIGH:
-        data_recived_size = 0;
-        current_frame.data_length |= (byte << 8);
-        if (current_frame.data_length == 0) {
-            rx_state = RX_STATE_CHECKSUM;
+        parser->data_recived_size = 0;
+        parser->check_recived_size = 0;
+        parser->checksum = 0;
+        parser->data_length |= (byte << 8);
+        parser->buffer[2] = byte;
+        if (parser->data_length == 0) {
+            parser->rx_state = RX_STATE_CHECKSUM;
             ret = PARSE_INCOMPLETE;
-        } else if (current_frame.data_length < FRAME_DATA_SIZE) {
-            rx_state = RX_STATE_DATA;
+        } else if (is_valid_length(parser, parser->data_length)) {
+            parser->rx_state = RX_STATE_DATA;
             ret = PARSE_INCOMPLETE;
         } else {
-            rx_state = RX_STATE_HEADER1;
+            command_parser_resync(parser, PARSER_HEADER_SIZE);
             ret = PARSE_ERROR_LENGTH;
         }
         break;
 
     case RX_STATE_DATA:
-        current_frame.data[data_recived_size++] = byte;
-        if (data_recived_size == current_frame.data_length) {
-            rx_state = RX_STATE_CHECKSUM;
+        parser->buffer[PARSER_HEADER_SIZE + parser->data_recived_size++] = byte;
+        if (parser->data_recived_size == parser->data_length) {
+            parser->rx_state = RX_STATE_CHECKSUM;
         }
         ret = PARSE_INCOMPLETE;
         break;
 
-    case RX_STATE_CHECKSUM:
-        current_frame.checksum = byte;
-        uint8_t checksum;
-
-        // // 调试：打印计算校验和的数据
-        // uint16_t calc_len = 1 + 2 + current_frame.data_length;
-        // printf("Calculating checksum for %d bytes: ", calc_len);
-        // for (int i = 0; i < calc_len; i++) {
-        //     printf("%02X ", *((uint8_t *)&current_frame.command + i));
-        // }
-        // printf("\n");
-
-        /*
-         *这里要解释一下命令字加数据长度(header_size)为什么是4字节
-         *因为command_frame_t结构体的command枚举量在上,数据位(2byte)在下，
-         *所以command填充为2byte
-         */
-        uint16_t header_size = sizeof(command_type_t) + sizeof(uint16_t);
-        checksum = calculate_checksum((uint8_t *)&current_frame,
-                                      header_size + current_frame.data_length);
-
-        if (checksum == current_frame.checksum) {
-            frame_ready = true;
+    case RX_STATE_CHECKSUM: {
+        // 校验值小端序，长度由本帧的校验方式决定
+        frame_check_t mode = command_frame_check(
+            (command_type_t)parser->buffer[0], parser->check_mode);
+        // 校验字节也存入缓冲，出错时用于重新查找帧头
+        parser->buffer[PARSER_HEADER_SIZE + parser->data_length +
+                       parser->check_recived_size] = byte;
+        parser->checksum |= (uint32_t)byte << (8 * parser->check_recived_size);
+        if (++parser->check_recived_size < command_check_size(mode)) {
+            ret = PARSE_INCOMPLETE;
+            break;
+        }
+
+        uint32_t checksum = command_calc_check(
+            mode, parser->buffer, PARSER_HEADER_SIZE + parser->data_length);
+        if (checksum == parser->checksum) {
+            parser->frame_ready = true;
+            parser->rx_state = RX_STATE_HEADER1;
+            ret = PARSE_SUCCESS;
+        } else if (command_parser_resync(
+                       parser, PARSER_HEADER_SIZE + parser->data_length +
+                                   parser->check_recived_size) ==
+                   PARSE_SUCCESS) {
+            // 错误帧中包含了完整的帧
             ret = PARSE_SUCCESS;
         } else {
             ret = PARSE_ERROR_CHECKSUM;
         }
-        rx_state = RX_STATE_HEADER1;
         break;
+    }
     default:
-        rx_state = RX_STATE_HEADER1;
+        parser->rx_state = RX_STATE_HEADER1;
         ret = PARSE_INCOMPLETE;
         break;
     }
     return ret;
 }
 
-bool command_get_frame(command_frame_t *frame) {
-    if (frame_ready) {
-        memcpy(frame, &current_frame, sizeof(command_frame_t));
-        frame_ready = false;
-        clear_command_frame(&current_frame);
+BOOT_ITCM bool command_parser_get_frame(command_parser_t *parser,
+                                        command_frame_t *frame) {
+    if (parser->frame_ready) {
+        // 帧缓冲与command_frame_t前部布局一致，只拷贝有效部分
+        memcpy(frame, parser->buffer, PARSER_HEADER_SIZE + parser->data_length);
+        frame->checksum = parser->checksum;
+        parser->frame_ready = false;
         return true;
     }
     return false;
 }
 
+void command_parser_init(void) {
+    command_parser_setup(&default_parser, default_parser_buffer,
+                         sizeof(default_parser_buffer));
+}
+
+rx_state_t get_rx_state(void) {
+    return command_parser_get_state(&default_parser);
+}
+
+parse_result_t command_process_byte(uint8_t byte) {
+    return command_parser_process_byte(&default_parser, byte);
+}
+
+bool command_get_frame(command_frame_t *frame) {
+    return command_parser_get_frame(&default_parser, frame);
+}
+
 uint16_t command_build_frame(command_type_t cmd, uint8_t *data,
                              uint16_t data_len, uint8_t *output_buffer) {
+    return command_build_frame_ex(cmd, data, data_len, FRAME_CHECK_SUM8,
+                                  output_buffer);
+}
+
+BOOT_ITCM uint16_t command_build_frame_ex(command_type_t cmd,
+                                          const uint8_t *data,
+                                          uint16_t data_len, frame_check_t mode,
+                                          uint8_t *output_buffer) {
     uint16_t index = 0;
 
     // 帧头
@@ -171,9 +513,12 @@ uint16_t command_build_frame(command_type_t cmd, uint8_t *data,
         index += data_len;
     }
 
-    // 校验和
-    uint8_t checksum = calculate_checksum(&output_buffer[2], index - 2);
-    output_buffer[index++] = checksum;
+    // 校验值（小端序）
+    mode = command_frame_check(cmd, mode);
+    uint32_t checksum = command_calc_check(mode, &output_buffer[2], index - 2);
+    for (uint8_t i = 0; i < command_check_size(mode); i++) {
+        output_buffer[index++] = (uint8_t)(checksum >> (8 * i));
+    }
 
     return index;
 }
@@ -18,6 +18,10 @@ typedef enum : uint8_t {
     CMD_ACK = 0x05,
     CMD_NACK = 0x06,
     CMD_ERROR_RESPONSE = 0x07,
+    CMD_ABORT = 0x08, // 中止正在进行的擦写或校验
+    CMD_STATUS = 0x09, // 查询状态和进度，擦写校验期间也立即应答
+    CMD_UPLOAD_RECORD = 0x0A, // 按地址上传一段固件，只擦写有数据的范围
+    CMD_BLOCK_CRC = 0x0B, // 按擦除块返回候选槽内容的CRC32，用于跳过未变化的块
     CMD_VALID_END
 } command_type_t;
 
@@ -33,13 +37,25 @@ struct test {
 #define FRAME_COMMAND_SIZE 1
 #define FRAME_DATA_LENGTH_INFO 2
 #define FRAMR_CHECK_SUM_SIZE 1
+// 帧尾校验字段最大长度（CRC32）
+#define FRAME_CHECK_MAX_SIZE 4
 
 // 命令帧数据长度大小
 #define FRAME_DATA_SIZE BOOT_FRAME_DATA_SIZE
 // 命令帧总长度
 #define FRAME_SIZE                                                             \
     ((FRAME_HEADER_SIZE * 2) + FRAME_COMMAND_SIZE + FRAME_DATA_LENGTH_INFO +   \
-     FRAME_DATA_SIZE + FRAMR_CHECK_SUM_SIZE)
+     FRAME_DATA_SIZE + FRAME_CHECK_MAX_SIZE)
+
+// 帧完整性校验方式，每次会话在CMD_ENTER_BOOT时协商，默认为8位和校验。
+// 校验范围均为命令字+长度+数据，校验值小端序放在帧尾。
+// CMD_ENTER_BOOT帧（请求和应答）始终使用8位和校验，保证随时可以重新协商
+typedef enum {
+    FRAME_CHECK_SUM8 = 0,  // 8位累加和取反，1字节
+    FRAME_CHECK_CRC16 = 1, // CRC-16/CCITT-FALSE，2字节
+    FRAME_CHECK_CRC32 = 2, // CRC-32/MPEG-2（与片上CRC单元默认配置一致），4字节
+    FRAME_CHECK_NUMS
+} frame_check_t;
 
 // 命令帧结构
 typedef struct __attribute__((__packed__)) {
@@ -47,7 +63,7 @@ typedef struct __attribute__((__packed__)) {
     // 上位机传来的长度为小端序组成的两字节数据，所以先收到低字节，再收高字节
     uint16_t data_length;
     uint8_t data[FRAME_DATA_SIZE];
-    uint8_t checksum;
+    uint32_t checksum; // 帧尾校验值，长度由校验方式决定
 } command_frame_t;
 // 解析结果
 typedef enum {
@@ -71,8 +87,74 @@ typedef enum {
     RX_STATE_CHECKSUM
 } rx_state_t;
 
+// 解析器帧缓冲大小：命令字+长度+数据+校验，数据最长max_data_length
+#define COMMAND_PARSER_BUFFER_SIZE(max_data_length)                            \
+    (FRAME_COMMAND_SIZE + FRAME_DATA_LENGTH_INFO + (max_data_length) +         \
+     FRAME_CHECK_MAX_SIZE)
+
+// 解析器实例，每个传输通道一个，互不干扰
+// 帧缓冲由调用者提供，可按用途放在DTCM（CPU解析）或D2 SRAM（DMA直接写入）
+typedef struct {
+    rx_state_t rx_state;
+    uint8_t *buffer;            // 帧缓冲，布局与command_frame_t前部一致
+    uint16_t data_recived_size; // 已接收的数据长度
+    uint16_t data_length;       // 正在接收的帧的数据长度
+    uint16_t max_data_length;   // 允许的最大数据长度，由缓冲和传输通道决定
+    uint32_t checksum;          // 已接收的帧尾校验值
+    uint8_t check_recived_size; // 已接收的校验字节数
+    frame_check_t check_mode;   // 当前会话的校验方式
+    bool frame_ready;
+} command_parser_t;
+
+/**
+ * @brief 初始化解析器实例
+ * @param parser 解析器
+ * @param buffer 帧缓冲，大小用COMMAND_PARSER_BUFFER_SIZE计算
+ * @param buffer_size 帧缓冲大小，决定允许的最大数据长度（不超过FRAME_DATA_SIZE）
+ */
+void command_parser_setup(command_parser_t *parser, uint8_t *buffer,
+                          uint16_t buffer_size);
+
+/**
+ * @brief 设置解析器的校验方式，command_parser_setup后默认为FRAME_CHECK_SUM8
+ */
+void command_parser_set_check(command_parser_t *parser, frame_check_t mode);
+
+/**
+ * @brief 进一步限制允许的最大数据长度，只能比帧缓冲允许的更小
+ */
+void command_parser_limit(command_parser_t *parser, uint16_t max_data_length);
+
+/**
+ * @brief 复位解析器实例的接收状态，丢弃未取出的帧
+ */
+void command_parser_reset(command_parser_t *parser);
+
+/**
+ * @brief 获取解析器实例的接收状态
+ */
+rx_state_t command_parser_get_state(const command_parser_t *parser);
+
+/**
+ * @brief 解析器实例按字节接收并解析命令帧
+ * @param parser 解析器
+ * @param byte 字节数据
+ * @return parse_result_t 解析结果
+ */
+parse_result_t command_parser_process_byte(command_parser_t *parser,
+                                           uint8_t byte);
+
+/**
+ * @brief 从解析器实例取出已完成的命令帧
+ * @details 只拷贝命令字、长度和实际长度的数据，frame中其余数据不确定
+ * @return true 获取成功 false 命令帧还没有准备好
+ */
+bool command_parser_get_frame(command_parser_t *parser,
+                              command_frame_t *frame);
+
 /**
  * @brief 初始化解析器
+ * @details 以下不带实例的接口操作默认解析器实例
  */
 void command_parser_init(void);
 
@@ -105,6 +187,33 @@ bool command_get_frame(command_frame_t *frame);
 uint16_t command_build_frame(command_type_t cmd, uint8_t *data,
                              uint16_t data_len, uint8_t *output_buffer);
 
+/**
+ * @brief 按指定校验方式构建命令帧，CMD_ENTER_BOOT始终使用8位和校验
+ * @return uint16_t 命令帧长度
+ */
+uint16_t command_build_frame_ex(command_type_t cmd, const uint8_t *data,
+                                uint16_t data_len, frame_check_t mode,
+                                uint8_t *output_buffer);
+
+/**
+ * @brief 命令帧实际使用的校验方式
+ */
+frame_check_t command_frame_check(command_type_t cmd, frame_check_t mode);
+
+/**
+ * @brief 校验字段长度
+ */
+uint8_t command_check_size(frame_check_t mode);
+
+/**
+ * @brief 计算校验值
+ * @param mode 校验方式
+ * @param data 命令字+长度+数据
+ * @param length 长度
+ */
+uint32_t command_calc_check(frame_check_t mode, const uint8_t *data,
+                            uint32_t length);
+
 #ifdef __cplusplus
 }
 #endif
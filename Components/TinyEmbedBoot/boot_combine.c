@@ -0,0 +1,83 @@
+#include "boot_combine.h"
+#include <string.h>
+
+// 低n位为1，n可以等于32
+static uint32_t Boot_CombineBits(uint32_t n) {
+    return n >= 32 ? 0xFFFFFFFFU : (1UL << n) - 1;
+}
+
+void Boot_CombineReset(BootCombine_t *combine) {
+    combine->offset = BOOT_COMBINE_NONE;
+    combine->mask = 0;
+}
+
+bool Boot_CombinePending(const BootCombine_t *combine) {
+    return combine->offset != BOOT_COMBINE_NONE;
+}
+
+bool Boot_CombineFull(const BootCombine_t *combine) {
+    return Boot_CombinePending(combine) &&
+           combine->mask == Boot_CombineBits(BOOT_FLASH_WORD_SIZE);
+}
+
+uint32_t Boot_CombineLength(const BootCombine_t *combine) {
+    return (uint32_t)__builtin_popcount(combine->mask);
+}
+
+uint32_t Boot_CombinePut(BootCombine_t *combine, uint32_t offset,
+                         const uint8_t *data, uint32_t length) {
+    uint32_t word = offset & ~(BOOT_FLASH_WORD_SIZE - 1);
+    uint32_t pos = offset - word;
+    uint32_t size = BOOT_FLASH_WORD_SIZE - pos;
+    uint32_t bits;
+
+    if (Boot_CombinePending(combine) && combine->offset != word) {
+        return 0;
+    }
+    if (size > length) {
+        size = length;
+    }
+    bits = Boot_CombineBits(size) << pos;
+    if (combine->mask & bits) {
+        // 同一段数据不能暂存两次
+        return 0;
+    }
+    if (!Boot_CombinePending(combine)) {
+        memset(combine->word, 0xFF, BOOT_FLASH_WORD_SIZE);
+        combine->offset = word;
+        combine->mask = 0;
+    }
+    memcpy(&combine->word[pos], data, size);
+    combine->mask |= bits;
+    return size;
+}
+
+BootErrorCode_t Boot_CombineMerge(BootCombine_t *combine, const uint8_t *flash,
+                                  bool reprogram, bool *program) {
+    bool written = false;
+
+    for (uint32_t i = 0; i < BOOT_FLASH_WORD_SIZE; i++) {
+        if (flash[i] == 0xFF) {
+            continue;
+        }
+        written = true;
+        if ((combine->mask & (1UL << i)) && combine->word[i] != flash[i]) {
+            // 已写入的字节不能改写
+            return ERROR_CODE_FIRMWARE_INVALID_DATA;
+        }
+        combine->word[i] = flash[i];
+    }
+    *program = memcmp(combine->word, flash, BOOT_FLASH_WORD_SIZE) != 0;
+    if (*program && written && !reprogram) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    return ERROR_CODE_NO_ERROR;
+}
+
+void Boot_CombineView(const BootCombine_t *combine, uint8_t *word) {
+    for (uint32_t i = 0; i < BOOT_FLASH_WORD_SIZE; i++) {
+        if (combine->mask & (1UL << i)) {
+            word[i] = combine->word[i];
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef _BOOT_COMBINE_H_
+#define _BOOT_COMBINE_H_
+#include "boot.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BOOT_COMBINE_NONE 0xFFFFFFFFU
+
+/*
+ * 写合并缓冲：不足一个闪存字的数据暂存在这里，凑满、下一段数据不在同一个
+ * 闪存字或上传结束时才写入。写入前读回闪存字原内容合并，已写入的数据不会被
+ * 0xFF填充的缓冲覆盖；只读写RAM，不访问flash，由boot.c读回和编程
+ */
+typedef struct {
+    uint32_t offset; // 暂存闪存字的槽内偏移，BOOT_COMBINE_NONE为没有暂存
+    uint32_t mask;   // 已填入数据的字节，第i位对应word[i]
+    uint8_t word[BOOT_FLASH_WORD_SIZE] ALIGNED(4);
+} BootCombine_t;
+
+_Static_assert(BOOT_FLASH_WORD_SIZE <= 32,
+               "BootCombine_t.mask must cover one flash word");
+
+/**
+ * @brief 丢弃暂存的数据
+ */
+void Boot_CombineReset(BootCombine_t *combine);
+
+/**
+ * @brief 是否有暂存的数据
+ */
+bool Boot_CombinePending(const BootCombine_t *combine);
+
+/**
+ * @brief 暂存的闪存字是否已填满
+ */
+bool Boot_CombineFull(const BootCombine_t *combine);
+
+/**
+ * @brief 暂存的字节数
+ */
+uint32_t Boot_CombineLength(const BootCombine_t *combine);
+
+/**
+ * @brief 把从offset开始、落在同一个闪存字内的数据并入缓冲
+ * @details 没有暂存时以offset所在的闪存字开始暂存；已有暂存时offset须在
+ *          同一个闪存字内，否则先由调用者写出
+ * @return 并入的字节数，不超过到闪存字结尾的长度；与已暂存的字节重叠或
+ *         不在暂存的闪存字内时返回0，缓冲不变
+ */
+uint32_t Boot_CombinePut(BootCombine_t *combine, uint32_t offset,
+                         const uint8_t *data, uint32_t length);
+
+/**
+ * @brief 写出前把闪存字的当前内容并入缓冲
+ * @details 已写入的字节保留原内容，暂存的数据须与它相同（重发的数据）；
+ *          闪存字全为0xFF时视为未编程
+ * @param flash 暂存闪存字在flash中的当前内容
+ * @param reprogram 已编程的闪存字能否再次编程：NOR flash只把1写成0，可以；
+ *                  片内flash带ECC，不能
+ * @param program 返回是否需要编程，合并后与flash内容相同时不必再写
+ * @return 暂存数据与已写入的字节不同，或需要再次编程而不允许时返回
+ *         ERROR_CODE_FIRMWARE_INVALID_DATA
+ */
+BootErrorCode_t Boot_CombineMerge(BootCombine_t *combine, const uint8_t *flash,
+                                  bool reprogram, bool *program);
+
+/**
+ * @brief 不写flash，得到暂存闪存字写出后的内容
+ * @details 用于CMD_BLOCK_CRC：把暂存的字节覆盖到flash当前内容上，闪存字
+ *          仍留在缓冲中等后续数据
+ * @param word 输入暂存闪存字在flash中的当前内容，返回写出后的内容
+ */
+void Boot_CombineView(const BootCombine_t *combine, uint8_t *word);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
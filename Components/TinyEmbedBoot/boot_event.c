@@ -0,0 +1,203 @@
+#include "boot_event.h"
+#include <stdatomic.h>
+
+#if (BOOT_EVENT_QUEUE_SIZE & (BOOT_EVENT_QUEUE_SIZE - 1)) != 0
+#error "BOOT_EVENT_QUEUE_SIZE must be a power of 2"
+#endif
+#if BOOT_FRAME_SLOT_NUMS < 1 || BOOT_FRAME_SLOT_NUMS > 32
+#error "BOOT_FRAME_SLOT_NUMS must be 1..32"
+#endif
+#if BOOT_TX_SMALL_NUMS + BOOT_TX_LARGE_NUMS > 32
+#error "BOOT_TX_SMALL_NUMS + BOOT_TX_LARGE_NUMS must not exceed 32"
+#endif
+
+// 有界无锁队列：每个单元带序号，序号等于写位置时可写，等于写位置+1时可读。
+// 生产者用CAS抢占写位置，抢到后再填数据并发布序号，被抢占的低优先级中断
+// 只会让消费者暂时看不到它之后的事件，不会丢失或交错
+typedef struct {
+    atomic_uint sequence;
+    BootEvent_t event;
+} BootEventCell_t;
+
+static BootEventCell_t event_cells[BOOT_EVENT_QUEUE_SIZE];
+static atomic_uint event_write_pos;
+static unsigned int event_read_pos;
+static atomic_uint event_dropped;
+
+// 帧槽，bit为1表示占用
+static command_frame_t frame_slots[BOOT_FRAME_SLOT_NUMS];
+static atomic_uint frame_slot_used;
+
+// 发送缓冲池，bit为1表示占用，小缓冲在低位，大缓冲在高位
+static uint8_t tx_small[BOOT_TX_SMALL_NUMS][BOOT_TX_SMALL_SIZE]
+    __attribute__((aligned(4)));
+static uint8_t tx_large[BOOT_TX_LARGE_NUMS][FRAME_SIZE]
+    __attribute__((aligned(4)));
+static atomic_uint tx_used;
+
+void Boot_EventReset(void) {
+    for (unsigned int i = 0; i < BOOT_EVENT_QUEUE_SIZE; i++) {
+        atomic_store_explicit(&event_cells[i].sequence, i,
+                              memory_order_relaxed);
+    }
+    atomic_store_explicit(&event_write_pos, 0, memory_order_relaxed);
+    event_read_pos = 0;
+    atomic_store_explicit(&event_dropped, 0, memory_order_relaxed);
+    atomic_store_explicit(&frame_slot_used, 0, memory_order_release);
+    atomic_store_explicit(&tx_used, 0, memory_order_release);
+}
+
+BOOT_ITCM bool Boot_EventPost(BootEventType_t type, uint8_t arg,
+                              uint16_t param) {
+    unsigned int pos =
+        atomic_load_explicit(&event_write_pos, memory_order_relaxed);
+    BootEventCell_t *cell;
+
+    for (;;) {
+        cell = &event_cells[pos & (BOOT_EVENT_QUEUE_SIZE - 1)];
+        unsigned int sequence =
+            atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        int diff = (int)(sequence - pos);
+        if (diff == 0) {
+            // 失败时pos被更新为最新写位置，重新尝试
+            if (atomic_compare_exchange_weak_explicit(
+                    &event_write_pos, &pos, pos + 1, memory_order_relaxed,
+                    memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 单元还没被消费者取走，队列满
+            atomic_fetch_add_explicit(&event_dropped, 1, memory_order_relaxed);
+            return false;
+        } else {
+            pos = atomic_load_explicit(&event_write_pos, memory_order_relaxed);
+        }
+    }
+    cell->event.type = (uint8_t)type;
+    cell->event.arg = arg;
+    cell->event.param = param;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+BOOT_ITCM bool Boot_EventGet(BootEvent_t *event) {
+    BootEventCell_t *cell =
+        &event_cells[event_read_pos & (BOOT_EVENT_QUEUE_SIZE - 1)];
+    unsigned int sequence =
+        atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    if (sequence != event_read_pos + 1) {
+        return false;
+    }
+    *event = cell->event;
+    // 单元交还给下一圈的生产者
+    atomic_store_explicit(&cell->sequence,
+                          event_read_pos + BOOT_EVENT_QUEUE_SIZE,
+                          memory_order_release);
+    event_read_pos++;
+    return true;
+}
+
+uint16_t Boot_EventCount(void) {
+    unsigned int write_pos =
+        atomic_load_explicit(&event_write_pos, memory_order_relaxed);
+    return (uint16_t)(write_pos - event_read_pos);
+}
+
+uint32_t Boot_EventDropped(void) {
+    return atomic_load_explicit(&event_dropped, memory_order_relaxed);
+}
+
+BOOT_ITCM command_frame_t *Boot_FrameAlloc(uint8_t *slot) {
+    unsigned int used =
+        atomic_load_explicit(&frame_slot_used, memory_order_relaxed);
+    for (;;) {
+        uint8_t index = 0;
+        while (index < BOOT_FRAME_SLOT_NUMS && (used & (1U << index))) {
+            index++;
+        }
+        if (index == BOOT_FRAME_SLOT_NUMS) {
+            atomic_fetch_add_explicit(&event_dropped, 1, memory_order_relaxed);
+            return NULL;
+        }
+        if (atomic_compare_exchange_weak_explicit(
+                &frame_slot_used, &used, used | (1U << index),
+                memory_order_acquire, memory_order_relaxed)) {
+            *slot = index;
+            return &frame_slots[index];
+        }
+    }
+}
+
+BOOT_ITCM command_frame_t *Boot_FrameGet(uint8_t slot) {
+    if (slot >= BOOT_FRAME_SLOT_NUMS) {
+        return NULL;
+    }
+    return &frame_slots[slot];
+}
+
+BOOT_ITCM void Boot_FrameRelease(uint8_t slot) {
+    if (slot >= BOOT_FRAME_SLOT_NUMS) {
+        return;
+    }
+    atomic_fetch_and_explicit(&frame_slot_used, ~(1U << slot),
+                              memory_order_release);
+}
+
+// 在[first, last)范围内申请一个空闲位，失败返回-1
+BOOT_ITCM static int Boot_TxBitAlloc(uint8_t first, uint8_t last) {
+    unsigned int used = atomic_load_explicit(&tx_used, memory_order_relaxed);
+    for (;;) {
+        uint8_t index = first;
+        while (index < last && (used & (1U << index))) {
+            index++;
+        }
+        if (index >= last) {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak_explicit(
+                &tx_used, &used, used | (1U << index), memory_order_acquire,
+                memory_order_relaxed)) {
+            return index;
+        }
+    }
+}
+
+BOOT_ITCM uint8_t *Boot_TxBufAlloc(uint16_t size) {
+    int index = -1;
+    if (size <= BOOT_TX_SMALL_SIZE) {
+        index = Boot_TxBitAlloc(0, BOOT_TX_SMALL_NUMS);
+    }
+    // 小缓冲用完时短应答也可以用大缓冲
+    if (index < 0 && size <= FRAME_SIZE) {
+        index = Boot_TxBitAlloc(BOOT_TX_SMALL_NUMS,
+                                BOOT_TX_SMALL_NUMS + BOOT_TX_LARGE_NUMS);
+    }
+    if (index < 0) {
+        return NULL;
+    }
+    if (index < BOOT_TX_SMALL_NUMS) {
+        return tx_small[index];
+    }
+    return tx_large[index - BOOT_TX_SMALL_NUMS];
+}
+
+BOOT_ITCM void Boot_TxBufRelease(const uint8_t *buffer) {
+    unsigned int index;
+    if (buffer >= &tx_small[0][0] &&
+        buffer < &tx_small[0][0] + sizeof(tx_small)) {
+        index = (unsigned int)(buffer - &tx_small[0][0]) / BOOT_TX_SMALL_SIZE;
+    } else if (buffer >= &tx_large[0][0] &&
+               buffer < &tx_large[0][0] + sizeof(tx_large)) {
+        index = BOOT_TX_SMALL_NUMS +
+                (unsigned int)(buffer - &tx_large[0][0]) / FRAME_SIZE;
+    } else {
+        // 不是池中的缓冲
+        return;
+    }
+    atomic_fetch_and_explicit(&tx_used, ~(1U << index), memory_order_release);
+}
+
+uint8_t Boot_TxBufInUse(void) {
+    return (uint8_t)__builtin_popcount(
+        atomic_load_explicit(&tx_used, memory_order_relaxed));
+}
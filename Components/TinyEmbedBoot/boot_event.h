@@ -0,0 +1,95 @@
+#ifndef _BOOT_EVENT_H_
+#define _BOOT_EVENT_H_
+#include "boot_cmd.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 事件类型，由中断投递，主循环按顺序取出处理
+typedef enum {
+    BOOT_EVENT_NONE = 0,
+    BOOT_EVENT_FRAME,       // 收到完整命令帧，arg为帧槽号
+    BOOT_EVENT_PARSE_ERROR, // 会话通道解析出错，arg为错误码
+    BOOT_EVENT_TX_DONE,     // 通道发送完成
+    BOOT_EVENT_KEY,         // 按键事件，arg为KEY_State_t
+    BOOT_EVENT_TIMEOUT,     // 启动模式等待超时
+} BootEventType_t;
+
+typedef struct {
+    uint8_t type; // BootEventType_t
+    uint8_t arg;
+    uint16_t param;
+} BootEvent_t;
+
+/**
+ * @brief 清空事件队列并释放所有帧槽，只能在没有中断投递时调用
+ */
+void Boot_EventReset(void);
+
+/**
+ * @brief 投递事件，可在任意优先级的中断中调用
+ * @details 无锁多生产者队列，不关中断，高优先级中断抢占时也不会互相覆盖
+ * @return 队列满时返回false，并计入丢弃计数
+ */
+bool Boot_EventPost(BootEventType_t type, uint8_t arg, uint16_t param);
+
+/**
+ * @brief 取出最早的事件，只能由主循环一个消费者调用
+ * @return 队列空时返回false
+ */
+bool Boot_EventGet(BootEvent_t *event);
+
+/**
+ * @brief 队列中待处理的事件数
+ */
+uint16_t Boot_EventCount(void);
+
+/**
+ * @brief 因队列满或没有空闲帧槽而丢弃的事件数
+ */
+uint32_t Boot_EventDropped(void);
+
+/**
+ * @brief 申请一个空闲帧槽，可在中断中调用
+ * @details 解析出的帧拷贝到帧槽后随BOOT_EVENT_FRAME投递，主循环处理完再释放，
+ *          处理期间新到的帧进入其他帧槽，不会覆盖正在处理的帧
+ * @param slot 返回帧槽号
+ * @return 帧槽，全部占用时返回NULL
+ */
+command_frame_t *Boot_FrameAlloc(uint8_t *slot);
+
+/**
+ * @brief 获取帧槽中的帧
+ */
+command_frame_t *Boot_FrameGet(uint8_t slot);
+
+/**
+ * @brief 释放帧槽
+ */
+void Boot_FrameRelease(uint8_t slot);
+
+/**
+ * @brief 从发送缓冲池申请缓冲，可在中断中调用
+ * @details 不超过BOOT_TX_SMALL_SIZE的优先用小缓冲，其余用完整帧大小的大缓冲
+ * @param size 需要的字节数
+ * @return 缓冲，没有合适的空闲缓冲时返回NULL
+ */
+uint8_t *Boot_TxBufAlloc(uint16_t size);
+
+/**
+ * @brief 释放发送缓冲，由通道在发送完成时调用（可在中断中），非池中的地址忽略
+ */
+void Boot_TxBufRelease(const uint8_t *buffer);
+
+/**
+ * @brief 已占用的发送缓冲个数
+ */
+uint8_t Boot_TxBufInUse(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,169 @@
+#include "boot_image.h"
+#include "crc.h"
+#include <stddef.h>
+#include <string.h>
+
+static BootImageReport_t last_report;
+
+/**
+ * @brief 按字喂入CRC单元
+ * @details CRC单元按MSB先入计算，小端读到的字先做字节反转，
+ *          与逐字节喂入结果一致，但每4字节只需一次总线写
+ */
+BOOT_ITCM static void Boot_ImageCRCFeed(const uint8_t *data, uint32_t length) {
+    const uint8_t *end = data + length;
+
+    // 头部非对齐字节
+    while (data < end && ((uintptr_t)data & 0x3) != 0) {
+        *(__IO uint8_t *)&CRC->DR = *data++;
+    }
+    const uint32_t *word = (const uint32_t *)data;
+    uint32_t words = (uint32_t)(end - data) >> 2;
+    // 展开4次，减少循环开销
+    while (words >= 4) {
+        CRC->DR = __REV(word[0]);
+        CRC->DR = __REV(word[1]);
+        CRC->DR = __REV(word[2]);
+        CRC->DR = __REV(word[3]);
+        word += 4;
+        words -= 4;
+    }
+    while (words--) {
+        CRC->DR = __REV(*word++);
+    }
+    // 尾部剩余字节
+    data = (const uint8_t *)word;
+    while (data < end) {
+        *(__IO uint8_t *)&CRC->DR = *data++;
+    }
+}
+
+const BootImageHeader_t *Boot_ImageGetHeader(uint32_t image_address) {
+    const BootImageHeader_t *header =
+        (const BootImageHeader_t *)(image_address + BOOT_IMAGE_HEADER_OFFSET);
+    if (header->magic != BOOT_IMAGE_MAGIC) {
+        return NULL;
+    }
+    return header;
+}
+
+uint32_t Boot_ImageCalcCRC(uint32_t image_address, uint32_t length) {
+    const uint8_t *image = (const uint8_t *)image_address;
+    uint32_t crc_offset =
+        BOOT_IMAGE_HEADER_OFFSET + offsetof(BootImageHeader_t, crc32);
+
+    // 使用MX_CRC_Init的默认多项式和初值，只复位计算结果
+    __HAL_CRC_DR_RESET(&hcrc);
+    Boot_ImageCRCFeed(image, crc_offset);
+    Boot_ImageCRCFeed(image + crc_offset + sizeof(uint32_t),
+                      length - crc_offset - sizeof(uint32_t));
+    return CRC->DR;
+}
+
+uint32_t Boot_ImageBlockCRC(uint32_t address, uint32_t length) {
+    __HAL_CRC_DR_RESET(&hcrc);
+    Boot_ImageCRCFeed((const uint8_t *)address, length);
+    return CRC->DR;
+}
+
+uint32_t Boot_ImageBlockCRCPatched(uint32_t address, uint32_t length,
+                                   uint32_t patch_offset, const uint8_t *patch,
+                                   uint32_t patch_len) {
+    const uint8_t *data = (const uint8_t *)address;
+    uint32_t patch_end = patch_offset + patch_len;
+
+    __HAL_CRC_DR_RESET(&hcrc);
+    Boot_ImageCRCFeed(data, patch_offset);
+    Boot_ImageCRCFeed(patch, patch_len);
+    Boot_ImageCRCFeed(data + patch_end, length - patch_end);
+    return CRC->DR;
+}
+
+BootErrorCode_t Boot_ImageCheckHeader(uint32_t image_address,
+                                      uint32_t max_size) {
+    uint32_t start = Boot_GetCycles();
+    const BootImageHeader_t *header = Boot_ImageGetHeader(image_address);
+
+    memset(&last_report, 0, sizeof(BootImageReport_t));
+    last_report.address = image_address;
+    if (header == NULL) {
+        return ERROR_CODE_FIRMWARE_VERIFY_FAILED;
+    }
+    last_report.version = header->version;
+    last_report.length = header->length;
+    last_report.crc32 = header->crc32;
+    if (header->length < BOOT_IMAGE_HEADER_OFFSET + sizeof(BootImageHeader_t) ||
+        header->length > max_size) {
+        return ERROR_CODE_FIRMWARE_VERIFY_FAILED;
+    }
+    last_report.elapsedUs = Boot_CyclesToUs(Boot_GetCycles() - start);
+    return ERROR_CODE_NO_ERROR;
+}
+
+BootErrorCode_t Boot_ImageVerifyBegin(BootImageVerifyJob_t *job,
+                                      uint32_t image_address,
+                                      uint32_t max_size) {
+    BootErrorCode_t err = Boot_ImageCheckHeader(image_address, max_size);
+    if (err != ERROR_CODE_NO_ERROR) {
+        return err;
+    }
+    job->address = image_address;
+    job->offset = 0;
+    job->length = last_report.length;
+    job->crc = 0xFFFFFFFF; // 与MX_CRC_Init的默认初值一致
+    job->cycles = 0;
+    return ERROR_CODE_NO_ERROR;
+}
+
+BOOT_ITCM bool Boot_ImageVerifyStep(BootImageVerifyJob_t *job, uint32_t chunk) {
+    const uint8_t *image = (const uint8_t *)job->address;
+    uint32_t crc_offset =
+        BOOT_IMAGE_HEADER_OFFSET + offsetof(BootImageHeader_t, crc32);
+    uint32_t start = Boot_GetCycles();
+    uint32_t begin = job->offset;
+    uint32_t end = (chunk < job->length - begin) ? begin + chunk : job->length;
+    uint32_t init = CRC->INIT;
+
+    // 两步之间CRC单元可能被帧校验使用，用INIT寄存器恢复上一步的结果
+    CRC->INIT = job->crc;
+    CRC->CR |= CRC_CR_RESET;
+    CRC->INIT = init;
+    // 跳过固件头中的crc32字段
+    if (begin < crc_offset) {
+        Boot_ImageCRCFeed(image + begin,
+                          (end < crc_offset ? end : crc_offset) - begin);
+    }
+    if (end > crc_offset + sizeof(uint32_t)) {
+        uint32_t from = begin > crc_offset + sizeof(uint32_t)
+                            ? begin
+                            : crc_offset + sizeof(uint32_t);
+        Boot_ImageCRCFeed(image + from, end - from);
+    }
+    job->crc = CRC->DR;
+    job->offset = end;
+    job->cycles += Boot_GetCycles() - start;
+    return job->offset >= job->length;
+}
+
+BootErrorCode_t Boot_ImageVerifyEnd(BootImageVerifyJob_t *job) {
+    last_report.elapsedUs = Boot_CyclesToUs(job->cycles);
+    last_report.fullScan = true;
+
+    if (job->offset < job->length || job->crc != last_report.crc32) {
+        last_report.crc32 = job->crc;
+        return ERROR_CODE_FIRMWARE_VERIFY_FAILED;
+    }
+    return ERROR_CODE_NO_ERROR;
+}
+
+BootErrorCode_t Boot_ImageVerify(uint32_t image_address, uint32_t max_size) {
+    BootImageVerifyJob_t job;
+    BootErrorCode_t err = Boot_ImageVerifyBegin(&job, image_address, max_size);
+    if (err != ERROR_CODE_NO_ERROR) {
+        return err;
+    }
+    Boot_ImageVerifyStep(&job, job.length);
+    return Boot_ImageVerifyEnd(&job);
+}
+
+const BootImageReport_t *Boot_ImageGetLastReport(void) { return &last_report; }
@@ -0,0 +1,130 @@
+#ifndef _BOOT_IMAGE_H_
+#define _BOOT_IMAGE_H_
+#include "boot.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 固件头标识 "TEBI"
+#define BOOT_IMAGE_MAGIC 0x49424554
+
+/*
+ * 固件头，紧跟在中断向量表之后（偏移BOOT_IMAGE_HEADER_OFFSET）
+ * 编译时只填magic，长度、版本和CRC32由构建后的scripts/boot_image.py写入
+ * crc32覆盖整个镜像，跳过crc32字段本身，算法与片上CRC单元默认配置一致：
+ * 多项式0x04C11DB7，初值0xFFFFFFFF，不反转，无结果异或
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t length; // 镜像总长度，byte，包含固件头
+    uint32_t crc32;
+} BootImageHeader_t;
+
+// 在app中定义固件头，链接脚本将.image_header段放在向量表之后
+#define BOOT_IMAGE_HEADER_DEFINE()                                             \
+    __attribute__((section(".image_header"), used))                           \
+    const BootImageHeader_t boot_image_header = {BOOT_IMAGE_MAGIC, 0, 0, 0}
+
+// 最近一次整镜像校验的结果
+typedef struct {
+    uint32_t address;   // 镜像执行地址
+    uint32_t version;
+    uint32_t length;
+    uint32_t crc32;     // 计算得到的CRC32，只检查固件头时为固件头中的值
+    uint32_t elapsedUs; // 校验耗时，微秒
+    bool fullScan;      // 是否做了整镜像CRC
+} BootImageReport_t;
+
+// 分步校验的进度，由协作式任务每次计算一段CRC
+typedef struct {
+    uint32_t address; // 镜像执行地址
+    uint32_t offset;  // 已计算的长度
+    uint32_t length;  // 固件头中的镜像长度
+    uint32_t crc;     // 已计算部分的CRC
+    uint32_t cycles;  // 累计计算耗时，CPU周期
+} BootImageVerifyJob_t;
+
+/**
+ * @brief 获取镜像的固件头
+ * @param image_address 镜像执行地址（须已可读，QSPI需内存映射）
+ * @return 固件头，magic不匹配时返回NULL
+ */
+const BootImageHeader_t *Boot_ImageGetHeader(uint32_t image_address);
+
+/**
+ * @brief 用硬件CRC单元计算镜像CRC32，跳过固件头中的crc32字段
+ * @param image_address 镜像执行地址
+ * @param length 镜像长度
+ * @return CRC32
+ */
+uint32_t Boot_ImageCalcCRC(uint32_t image_address, uint32_t length);
+
+/**
+ * @brief 用硬件CRC单元计算一段数据的CRC32，不跳过任何字段
+ * @details 算法与FRAME_CHECK_CRC32相同，用于按块比较槽内容
+ * @param address 数据地址（须已可读，QSPI需内存映射）
+ * @param length 长度
+ * @return CRC32
+ */
+uint32_t Boot_ImageBlockCRC(uint32_t address, uint32_t length);
+
+/**
+ * @brief 同Boot_ImageBlockCRC，其中[patch_offset, patch_offset + patch_len)
+ *        一段改用RAM中的patch计算
+ * @details 用于把还没写出的数据算进块CRC，patch须在块内
+ */
+uint32_t Boot_ImageBlockCRCPatched(uint32_t address, uint32_t length,
+                                   uint32_t patch_offset, const uint8_t *patch,
+                                   uint32_t patch_len);
+
+/**
+ * @brief 只检查固件头：magic和长度，不计算CRC，并记录耗时
+ * @details 用于校验令牌有效时的快速启动
+ * @param image_address 镜像执行地址
+ * @param max_size 镜像所在槽大小
+ * @return 错误码
+ */
+BootErrorCode_t Boot_ImageCheckHeader(uint32_t image_address,
+                                      uint32_t max_size);
+
+/**
+ * @brief 校验整个镜像：固件头、长度和CRC32，并记录耗时
+ * @param image_address 镜像执行地址
+ * @param max_size 镜像所在槽大小
+ * @return 错误码
+ */
+BootErrorCode_t Boot_ImageVerify(uint32_t image_address, uint32_t max_size);
+
+/**
+ * @brief 开始分步校验，先检查固件头
+ * @return 固件头无效时返回错误码
+ */
+BootErrorCode_t Boot_ImageVerifyBegin(BootImageVerifyJob_t *job,
+                                      uint32_t image_address,
+                                      uint32_t max_size);
+
+/**
+ * @brief 继续计算最多chunk字节的CRC
+ * @return 整个镜像计算完成返回true
+ */
+bool Boot_ImageVerifyStep(BootImageVerifyJob_t *job, uint32_t chunk);
+
+/**
+ * @brief 结束分步校验，比较CRC32并记录结果
+ * @return 没有算完或CRC32不一致返回ERROR_CODE_FIRMWARE_VERIFY_FAILED
+ */
+BootErrorCode_t Boot_ImageVerifyEnd(BootImageVerifyJob_t *job);
+
+/**
+ * @brief 获取最近一次Boot_ImageVerify的结果
+ */
+const BootImageReport_t *Boot_ImageGetLastReport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,116 @@
+#include "boot_resume.h"
+#include <stddef.h>
+#include <string.h>
+
+static BootResumeState_t *resume_state = NULL;
+// 已写入的包数，只在RAM中，绑定存储时由位图重新统计
+static uint32_t resume_done = 0;
+
+static uint32_t Boot_ResumeCheck(const BootResumeState_t *state) {
+    return ~(state->magic ^ state->sessionId ^ state->packetSize ^
+             state->packetTotalNum);
+}
+
+static bool Boot_ResumeActive(void) {
+    return resume_state != NULL && resume_state->sessionId != 0;
+}
+
+void Boot_ResumeInit(BootResumeState_t *state) {
+    resume_state = state;
+    resume_done = 0;
+    if (state->magic != BOOT_RESUME_MAGIC ||
+        state->check != Boot_ResumeCheck(state) ||
+        state->packetTotalNum > BOOT_RESUME_MAX_PACKETS) {
+        Boot_ResumeClear();
+        return;
+    }
+    for (uint32_t i = 0; i < state->packetTotalNum; i++) {
+        if (Boot_ResumeIsDone(i)) {
+            resume_done++;
+        }
+    }
+}
+
+void Boot_ResumeStart(uint32_t session_id, uint32_t packet_size,
+                      uint32_t packet_total) {
+    // 先作废记录再清位图，中途复位不会留下带旧位图的有效会话
+    resume_state->check = 0;
+    memset(resume_state->bitmap, 0, sizeof(resume_state->bitmap));
+    resume_state->magic = BOOT_RESUME_MAGIC;
+    resume_state->sessionId = session_id;
+    resume_state->packetSize = packet_size;
+    resume_state->packetTotalNum = packet_total;
+    resume_state->check = Boot_ResumeCheck(resume_state);
+    resume_done = 0;
+}
+
+void Boot_ResumeClear(void) {
+    if (resume_state == NULL) {
+        return;
+    }
+    memset(resume_state, 0, sizeof(BootResumeState_t));
+    resume_done = 0;
+}
+
+uint32_t Boot_ResumeSession(uint32_t packet_size) {
+    if (!Boot_ResumeActive() || resume_state->packetSize != packet_size) {
+        return 0;
+    }
+    return resume_state->sessionId;
+}
+
+uint32_t Boot_ResumeTotal(void) {
+    return Boot_ResumeActive() ? resume_state->packetTotalNum : 0;
+}
+
+bool Boot_ResumeMark(uint32_t packet_num) {
+    if (!Boot_ResumeActive() || packet_num >= resume_state->packetTotalNum) {
+        return false;
+    }
+    if (!Boot_ResumeIsDone(packet_num)) {
+        resume_state->bitmap[packet_num / 32] |= 1UL << (packet_num % 32);
+        resume_done++;
+    }
+    return true;
+}
+
+bool Boot_ResumeIsDone(uint32_t packet_num) {
+    return Boot_ResumeActive() && packet_num < resume_state->packetTotalNum &&
+           (resume_state->bitmap[packet_num / 32] &
+            (1UL << (packet_num % 32))) != 0;
+}
+
+uint32_t Boot_ResumeDoneCount(void) { return resume_done; }
+
+uint32_t Boot_ResumeImageLength(void) {
+    if (!Boot_ResumeActive() || resume_done != resume_state->packetTotalNum) {
+        return 0;
+    }
+    return resume_state->packetTotalNum * resume_state->packetSize;
+}
+
+uint8_t Boot_ResumeGetMissing(BootResumeRange_t *ranges, uint8_t max_ranges) {
+    uint8_t nums = 0;
+    uint32_t total = Boot_ResumeTotal();
+    uint32_t i = 0;
+
+    while (i < total && nums < max_ranges) {
+        uint32_t word = resume_state->bitmap[i / 32];
+        if ((i % 32) == 0 && word == 0xFFFFFFFFU) {
+            // 整个字都已写入
+            i += 32;
+            continue;
+        }
+        if ((word & (1UL << (i % 32))) != 0) {
+            i++;
+            continue;
+        }
+        ranges[nums].first = i;
+        while (i < total && !Boot_ResumeIsDone(i)) {
+            i++;
+        }
+        ranges[nums].count = i - ranges[nums].first;
+        nums++;
+    }
+    return nums;
+}
@@ -0,0 +1,98 @@
+#ifndef _BOOT_RESUME_H_
+#define _BOOT_RESUME_H_
+#include "boot_cfg.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 续传记录标识 "RSUM"
+#define BOOT_RESUME_MAGIC 0x4D555352
+#define BOOT_RESUME_BITMAP_WORDS ((BOOT_RESUME_MAX_PACKETS + 31) / 32)
+
+// 上传进度，按包号记录已写入flash的包，可放在备份SRAM中跨复位保存
+typedef struct {
+    uint32_t magic;
+    uint32_t sessionId;      // 第一包写入时生成，0为没有会话
+    uint32_t packetSize;     // 会话协商的固件包大小，包号按它换算地址
+    uint32_t packetTotalNum; // 会话的总包数
+    uint32_t check;          // 以上字段异或后取反，判断备份SRAM内容是否有效
+    uint32_t bitmap[BOOT_RESUME_BITMAP_WORDS]; // bit为1表示该包已写入
+} BootResumeState_t;
+#if BOOT_RESUME_PERSIST
+_Static_assert(BOOT_RESUME_RAM_ADDRESS + sizeof(BootResumeState_t) <=
+                   BOOT_SHARED_RAM_ADDRESS + BOOT_SHARED_RAM_SIZE,
+               "BootResumeState_t must fit the backup SRAM after "
+               "BOOT_RESUME_RAM_ADDRESS");
+#endif
+
+// 连续缺失的包
+typedef struct {
+    uint32_t first; // 第一个缺失的包号
+    uint32_t count; // 包数
+} BootResumeRange_t;
+
+/**
+ * @brief 绑定进度存储，内容无效时清空。在Boot_SlotInit之后调用
+ * @param state 进度存储，备份SRAM或普通RAM
+ */
+void Boot_ResumeInit(BootResumeState_t *state);
+
+/**
+ * @brief 开始新会话，清空位图。第一包擦除候选槽时调用
+ */
+void Boot_ResumeStart(uint32_t session_id, uint32_t packet_size,
+                      uint32_t packet_total);
+
+/**
+ * @brief 结束会话：校验完成、中止或改为按地址上传时调用
+ */
+void Boot_ResumeClear(void);
+
+/**
+ * @brief 获取可续传的会话
+ * @param packet_size 本次会话协商的包大小，与会话不同时包号对不上，不能续传
+ * @return 会话id，没有会话或包大小不同时返回0
+ */
+uint32_t Boot_ResumeSession(uint32_t packet_size);
+
+/**
+ * @brief 获取会话的总包数，没有会话时返回0
+ */
+uint32_t Boot_ResumeTotal(void);
+
+/**
+ * @brief 记录一个包已写入
+ * @return 包号超出会话范围时返回false
+ */
+bool Boot_ResumeMark(uint32_t packet_num);
+
+/**
+ * @brief 包是否已写入
+ */
+bool Boot_ResumeIsDone(uint32_t packet_num);
+
+/**
+ * @brief 已写入的包数
+ */
+uint32_t Boot_ResumeDoneCount(void);
+
+/**
+ * @brief 全部包写入后返回镜像长度（总包数乘包大小），否则返回0
+ */
+uint32_t Boot_ResumeImageLength(void);
+
+/**
+ * @brief 列出缺失的包范围，从小到大
+ * @param ranges 输出
+ * @param max_ranges ranges的个数，缺失范围更多时只列出前max_ranges段
+ * @return 填入的范围个数
+ */
+uint8_t Boot_ResumeGetMissing(BootResumeRange_t *ranges, uint8_t max_ranges);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,571 @@
+#include "boot_slot.h"
+#include "boot_slot_meta.h"
+#include "crc.h"
+#include "qspi_flash_driver.h"
+#include <stddef.h>
+#include <string.h>
+
+extern QSPI_FLASH_Device_t QSPI_Flash;
+
+#if (BOOT_SLOT_B_QSPI_OFFSET % QSPI_FLASH_SECTOR_SIZE) != 0 ||                 \
+    (BOOT_SLOT_META_QSPI_OFFSET % QSPI_FLASH_SECTOR_SIZE) != 0
+#error "QSPI slot and metadata offsets must be 4 KB sector aligned"
+#endif
+#if BOOT_SLOT_B_QSPI_OFFSET < BOOT_SLOT_META_QSPI_OFFSET +                     \
+                                  2 * QSPI_FLASH_SECTOR_SIZE &&                 \
+    BOOT_SLOT_META_QSPI_OFFSET < BOOT_SLOT_B_QSPI_OFFSET + BOOT_SLOT_B_SIZE
+#error "Slot B overlaps the two slot metadata sectors"
+#endif
+
+// 共享RAM中app写入的确认请求
+#define BOOT_SLOT_CONFIRM_WORD (*(volatile uint32_t *)BOOT_SHARED_RAM_ADDRESS)
+// 共享RAM中上次整镜像校验后的复位次数，及其取反值用于判断内容是否有效
+#define BOOT_SLOT_VERIFY_COUNT_WORD                                            \
+    (*(volatile uint32_t *)(BOOT_SHARED_RAM_ADDRESS + 4))
+#define BOOT_SLOT_VERIFY_COUNT_CHECK_WORD                                      \
+    (*(volatile uint32_t *)(BOOT_SHARED_RAM_ADDRESS + 8))
+
+// 槽的存储区域
+static const BootSlotRegion_t slot_region[BOOT_SLOT_NUMS] = {
+    [BOOT_SLOT_A] = {BOOT_SLOT_STORAGE_INTERNAL, BOOT_SLOT_A_ADDRESS,
+                     BOOT_SLOT_A_ADDRESS, BOOT_SLOT_A_SIZE},
+    [BOOT_SLOT_B] = {BOOT_SLOT_STORAGE_QSPI,
+                     QSPI_FLASH_MEM_ADDRESS + BOOT_SLOT_B_QSPI_OFFSET,
+                     BOOT_SLOT_B_QSPI_OFFSET, BOOT_SLOT_B_SIZE},
+};
+
+static BootSlotMeta_t slot_meta;
+// 最新记录所在扇区，下一次提交写另一个扇区
+static uint8_t slot_meta_sector = 0;
+
+// 擦除块：QSPI为4KB扇区，片内flash为扇区，按扇区边界从槽起始地址向下对齐编号
+#define BOOT_SLOT_ERASE_UNITS_A                                                \
+    ((BOOT_SLOT_A_ADDRESS % FLASH_SECTOR_SIZE + BOOT_SLOT_A_SIZE +             \
+      FLASH_SECTOR_SIZE - 1) /                                                 \
+     FLASH_SECTOR_SIZE)
+#define BOOT_SLOT_ERASE_UNITS_B (BOOT_SLOT_B_SIZE / QSPI_FLASH_SECTOR_SIZE)
+#define BOOT_SLOT_ERASE_UNITS                                                  \
+    (BOOT_SLOT_ERASE_UNITS_A > BOOT_SLOT_ERASE_UNITS_B                         \
+         ? BOOT_SLOT_ERASE_UNITS_A                                             \
+         : BOOT_SLOT_ERASE_UNITS_B)
+// 本次升级中已擦除的块，只记录最近一次作废的槽，按地址写入时每块只擦一次
+static uint32_t slot_erased[(BOOT_SLOT_ERASE_UNITS + 31) / 32];
+static BootSlot_t slot_erased_slot = BOOT_SLOT_A;
+
+static uint32_t Boot_SlotMetaCRC(const BootSlotMeta_t *meta) {
+    return HAL_CRC_Calculate(&hcrc, (uint32_t *)meta,
+                             offsetof(BootSlotMeta_t, crc32));
+}
+
+static void Boot_SlotSetVerifyCount(uint32_t count) {
+    BOOT_SLOT_VERIFY_COUNT_WORD = count;
+    BOOT_SLOT_VERIFY_COUNT_CHECK_WORD = ~count;
+}
+
+static uint32_t Boot_SlotMetaAddress(uint8_t sector) {
+    return BOOT_SLOT_META_QSPI_OFFSET + sector * QSPI_FLASH_SECTOR_SIZE;
+}
+
+// QSPI flash未初始化或容量不够时，元数据和B槽都不可用
+static bool Boot_SlotMetaPersistent(void) {
+    return QSPI_Flash.flashSize >=
+           BOOT_SLOT_META_QSPI_OFFSET + 2 * QSPI_FLASH_SECTOR_SIZE;
+}
+
+uint32_t Boot_SlotBlockSize(BootSlot_t slot) {
+    return slot_region[slot].storage == BOOT_SLOT_STORAGE_QSPI
+               ? QSPI_FLASH_SECTOR_SIZE
+               : FLASH_SECTOR_SIZE;
+}
+
+static uint32_t Boot_SlotEraseUnit(BootSlot_t slot, uint32_t addr) {
+    uint32_t unit_size = Boot_SlotBlockSize(slot);
+    uint32_t base = slot_region[slot].storageAddress & ~(unit_size - 1);
+    return (addr - base) / unit_size;
+}
+
+static bool Boot_SlotIsErased(BootSlot_t slot, uint32_t addr) {
+    uint32_t unit = Boot_SlotEraseUnit(slot, addr);
+    return slot == slot_erased_slot &&
+           (slot_erased[unit / 32] & (1UL << (unit % 32))) != 0;
+}
+
+// 标记[addr, end)内的块已擦除，addr和end按擦除块对齐
+static void Boot_SlotMarkErased(BootSlot_t slot, uint32_t addr, uint32_t end) {
+    if (slot != slot_erased_slot) {
+        return;
+    }
+    for (; addr < end; addr += Boot_SlotBlockSize(slot)) {
+        uint32_t unit = Boot_SlotEraseUnit(slot, addr);
+        slot_erased[unit / 32] |= 1UL << (unit % 32);
+    }
+}
+
+static bool Boot_SlotStorageReady(BootSlot_t slot) {
+    const BootSlotRegion_t *region = &slot_region[slot];
+    if (region->storage == BOOT_SLOT_STORAGE_QSPI) {
+        return QSPI_Flash.flashSize >= region->storageAddress + region->size;
+    }
+    return true;
+}
+
+// 槽能否擦写：与boot共用扇区的片内槽无法擦除，已编程的闪存字不能再次编程
+static bool Boot_SlotUpdatable(BootSlot_t slot) {
+    if (slot_region[slot].storage == BOOT_SLOT_STORAGE_INTERNAL) {
+        return !BOOT_APP_SHARE_SECTOR;
+    }
+    return Boot_SlotStorageReady(slot);
+}
+
+/**
+ * @brief 提交元数据到另一个扇区
+ * @details 先擦后写另一个扇区，旧记录在新记录写完前一直有效，
+ *          任意时刻断电都能读回一条完整记录
+ */
+static BootErrorCode_t Boot_SlotCommit(void) {
+    if (!Boot_SlotMetaPersistent()) {
+        // 没有QSPI时只在RAM中生效，只能运行A槽出厂固件
+        return ERROR_CODE_NO_ERROR;
+    }
+    uint8_t target = slot_meta_sector ^ 1;
+    uint32_t addr = Boot_SlotMetaAddress(target);
+
+    slot_meta.magic = BOOT_SLOT_META_MAGIC;
+    slot_meta.sequence++;
+    slot_meta.crc32 = Boot_SlotMetaCRC(&slot_meta);
+    if (QSPI_FLASH_Erase(&QSPI_Flash, addr, QSPI_FLASH_SECTOR_SIZE) != 0 ||
+        QSPI_FLASH_Write(&QSPI_Flash, addr, (const uint8_t *)&slot_meta,
+                         sizeof(BootSlotMeta_t)) != 0) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    slot_meta_sector = target;
+    return ERROR_CODE_NO_ERROR;
+}
+
+void Boot_SlotInit(void) {
+    BootSlotMeta_t record;
+    bool found = false;
+
+    Boot_SlotMetaDefault(&slot_meta);
+    slot_meta_sector = 1;
+    if (Boot_SlotMetaPersistent()) {
+        for (uint8_t sector = 0; sector < 2; sector++) {
+            if (QSPI_FLASH_Read(&QSPI_Flash, Boot_SlotMetaAddress(sector),
+                                (uint8_t *)&record,
+                                sizeof(BootSlotMeta_t)) != 0) {
+                continue;
+            }
+            if (record.magic != BOOT_SLOT_META_MAGIC ||
+                record.activeSlot >= BOOT_SLOT_NUMS ||
+                record.crc32 != Boot_SlotMetaCRC(&record)) {
+                continue;
+            }
+            // 序号按有符号差比较，回绕后仍能取到最新记录
+            if (!found || (int32_t)(record.sequence - slot_meta.sequence) > 0) {
+                slot_meta = record;
+                slot_meta_sector = sector;
+                found = true;
+            }
+        }
+    }
+
+    // 处理app上次运行时留下的确认请求
+    __HAL_RCC_BKPRAM_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    if (BOOT_SLOT_CONFIRM_WORD == BOOT_SLOT_CONFIRM_MAGIC) {
+        BOOT_SLOT_CONFIRM_WORD = 0;
+        Boot_SlotConfirm();
+    }
+    // 累计复位次数，上电后内容无效则从0开始
+    if (BOOT_SLOT_VERIFY_COUNT_CHECK_WORD != ~BOOT_SLOT_VERIFY_COUNT_WORD) {
+        Boot_SlotSetVerifyCount(0);
+    } else if (BOOT_SLOT_VERIFY_COUNT_WORD < BOOT_IMAGE_VERIFY_INTERVAL) {
+        Boot_SlotSetVerifyCount(BOOT_SLOT_VERIFY_COUNT_WORD + 1);
+    }
+}
+
+BootSlot_t Boot_SlotGetActive(void) {
+    return (BootSlot_t)slot_meta.activeSlot;
+}
+
+BootSlot_t Boot_SlotGetCandidate(void) { return Boot_SlotMetaCandidate(); }
+
+const BootSlotInfo_t *Boot_SlotGetInfo(BootSlot_t slot) {
+    return &slot_meta.slot[slot];
+}
+
+const BootSlotRegion_t *Boot_SlotGetRegion(BootSlot_t slot) {
+    return &slot_region[slot];
+}
+
+uint32_t Boot_SlotMap(BootSlot_t slot) {
+    const BootSlotRegion_t *region = &slot_region[slot];
+    if (region->storage == BOOT_SLOT_STORAGE_QSPI) {
+        if (!Boot_SlotStorageReady(slot) ||
+            QSPI_FLASH_EnableMemoryMapped(&QSPI_Flash) != 0) {
+            return 0;
+        }
+    }
+    return region->execAddress;
+}
+
+// 按256位闪存字编程片内flash，地址和长度由Boot_SlotWriteBegin保证按闪存字对齐
+BOOT_ITCM static BootErrorCode_t Boot_SlotWriteInternal(uint32_t flashAddr,
+                                                        const uint8_t *data,
+                                                        uint32_t len) {
+    // 解锁Flash
+    if (HAL_FLASH_Unlock() != HAL_OK) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    for (uint32_t byte_offset = 0; byte_offset < len;
+         byte_offset += BOOT_FLASH_WORD_SIZE) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_FLASHWORD,
+                              flashAddr + byte_offset, // 直接使用字节偏移
+                              (uint32_t)(data + byte_offset)) != HAL_OK) {
+            HAL_FLASH_Lock();
+            return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+        }
+    }
+    HAL_FLASH_Lock();
+    return ERROR_CODE_NO_ERROR;
+}
+
+// 擦除片内flash中与[job->addr, job->end)相交的下一个扇区，本次升级已擦过的扇区跳过，
+// 槽从扇区边界开始由Boot_SlotUpdatable保证
+BOOT_ITCM static BootSlotJobState_t
+Boot_SlotEraseInternalStep(BootSlotJob_t *job) {
+    FLASH_EraseInitTypeDef erase;
+    uint32_t sectorError;
+
+    erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+    erase.Banks = FLASH_BANK_1;
+    erase.NbSectors = 1;
+    erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    while (job->addr < job->end) {
+        // job->addr所在的扇区
+        uint32_t sector = (job->addr - FLASH_BANK1_BASE) / FLASH_SECTOR_SIZE;
+        uint32_t start = FLASH_BANK1_BASE + sector * FLASH_SECTOR_SIZE;
+        if (sector >= FLASH_SECTOR_TOTAL) {
+            job->addr = job->end;
+            break;
+        }
+        job->addr = start + FLASH_SECTOR_SIZE;
+        if (Boot_SlotIsErased(job->slot, start)) {
+            continue;
+        }
+        erase.Sector = sector;
+        if (HAL_FLASH_Unlock() != HAL_OK) {
+            return BOOT_SLOT_JOB_ERROR;
+        }
+        HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &sectorError);
+        HAL_FLASH_Lock();
+        if (status != HAL_OK) {
+            return BOOT_SLOT_JOB_ERROR;
+        }
+        Boot_SlotMarkErased(job->slot, start, start + FLASH_SECTOR_SIZE);
+        job->done += FLASH_SECTOR_SIZE;
+        job->blocks++;
+        return BOOT_SLOT_JOB_AGAIN;
+    }
+    return BOOT_SLOT_JOB_DONE;
+}
+
+// 启动QSPI flash的下一块擦除或下一页编程，上一步未完成时不推进
+BOOT_ITCM static BootSlotJobState_t Boot_SlotQSPIStep(BootSlotJob_t *job) {
+    if (QSPI_FLASH_IsBusy(&QSPI_Flash)) {
+        if (HAL_GetTick() - job->startTick > job->timeout) {
+            // 超时，中止自动轮询
+            QSPI_FLASH_WaitReady(&QSPI_Flash, 0);
+            return BOOT_SLOT_JOB_ERROR;
+        }
+        return BOOT_SLOT_JOB_BUSY;
+    }
+    if (QSPI_Flash.error) {
+        return BOOT_SLOT_JOB_ERROR;
+    }
+    if (job->pending != 0) {
+        // 上一块擦除或上一页编程已完成
+        if (job->data == NULL) {
+            Boot_SlotMarkErased(job->slot, job->addr - job->pending, job->addr);
+        }
+        job->done += job->pending;
+        job->blocks++;
+        job->pending = 0;
+    }
+    if (job->data == NULL) {
+        // 跳过本次升级已擦过的扇区，只合并连续未擦除的扇区
+        while (job->addr < job->end &&
+               Boot_SlotIsErased(job->slot, job->addr)) {
+            job->addr += QSPI_FLASH_SECTOR_SIZE;
+        }
+    }
+    if (job->addr >= job->end) {
+        return BOOT_SLOT_JOB_DONE;
+    }
+
+    uint32_t size;
+    int32_t ret;
+    if (job->data == NULL) {
+        uint32_t run = QSPI_FLASH_SECTOR_SIZE;
+        while (job->addr + run < job->end &&
+               !Boot_SlotIsErased(job->slot, job->addr + run)) {
+            run += QSPI_FLASH_SECTOR_SIZE;
+        }
+        size = QSPI_FLASH_GetEraseBlockSize(job->addr, run);
+        ret = QSPI_FLASH_StartEraseBlock(&QSPI_Flash, job->addr, size);
+        job->timeout = QSPI_FLASH_TIMEOUT_ERASE_64K;
+    } else {
+        // 每次最多写到当前页末尾
+        size = QSPI_FLASH_PAGE_SIZE - (job->addr % QSPI_FLASH_PAGE_SIZE);
+        if (size > job->end - job->addr) {
+            size = job->end - job->addr;
+        }
+        ret = QSPI_FLASH_StartProgramPage(&QSPI_Flash, job->addr, job->data,
+                                          size);
+        job->timeout = QSPI_FLASH_TIMEOUT_PAGE_PROGRAM + 1;
+        job->data += size;
+    }
+    if (ret != 0) {
+        return BOOT_SLOT_JOB_ERROR;
+    }
+    job->startTick = HAL_GetTick();
+    job->addr += size;
+    job->pending = size;
+    return BOOT_SLOT_JOB_AGAIN;
+}
+
+BootErrorCode_t Boot_SlotInvalidate(BootSlot_t slot) {
+    // 先作废再擦写
+    Boot_SlotMetaInvalidate(&slot_meta, slot);
+    memset(slot_erased, 0, sizeof(slot_erased));
+    slot_erased_slot = slot;
+    return Boot_SlotCommit();
+}
+
+BootErrorCode_t Boot_SlotEraseBegin(BootSlotJob_t *job, BootSlot_t slot,
+                                    uint32_t length) {
+    const BootSlotRegion_t *region = &slot_region[slot];
+
+    if (length == 0 || length > region->size) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+
+    BootErrorCode_t err = Boot_SlotInvalidate(slot);
+    if (err != ERROR_CODE_NO_ERROR) {
+        return err;
+    }
+    return Boot_SlotEraseRangeBegin(job, slot, 0, length);
+}
+
+BootErrorCode_t Boot_SlotEraseRangeBegin(BootSlotJob_t *job, BootSlot_t slot,
+                                         uint32_t offset, uint32_t len) {
+    const BootSlotRegion_t *region = &slot_region[slot];
+
+    if (len == 0 || offset >= region->size || len > region->size - offset) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    if (!Boot_SlotUpdatable(slot)) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    job->slot = slot;
+    job->data = NULL;
+    job->addr = region->storageAddress + offset;
+    job->end = job->addr + len;
+    job->startTick = HAL_GetTick();
+    job->timeout = 0;
+    job->pending = 0;
+    job->done = 0;
+    job->blocks = 0;
+    if (region->storage == BOOT_SLOT_STORAGE_QSPI) {
+        // 范围按4KB向外扩展
+        job->addr &= ~(QSPI_FLASH_SECTOR_SIZE - 1);
+        job->end = (job->end + QSPI_FLASH_SECTOR_SIZE - 1) &
+                   ~(QSPI_FLASH_SECTOR_SIZE - 1);
+    }
+    return ERROR_CODE_NO_ERROR;
+}
+
+BootErrorCode_t Boot_SlotWriteBegin(BootSlotJob_t *job, BootSlot_t slot,
+                                    uint32_t offset, const uint8_t *data,
+                                    uint32_t len) {
+    const BootSlotRegion_t *region = &slot_region[slot];
+
+    if (data == NULL || offset >= region->size || len > region->size - offset) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    if (!Boot_SlotUpdatable(slot)) {
+        return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+    }
+    // 片内flash的闪存字对齐由调用者保证：槽地址和协商的包大小在编译时检查
+    job->slot = slot;
+    job->data = data;
+    job->addr = region->storageAddress + offset;
+    job->end = job->addr + len;
+    job->startTick = HAL_GetTick();
+    job->timeout = 0;
+    job->pending = 0;
+    job->done = 0;
+    job->blocks = 0;
+    return ERROR_CODE_NO_ERROR;
+}
+
+BOOT_ITCM BootSlotJobState_t Boot_SlotJobStep(BootSlotJob_t *job) {
+    if (slot_region[job->slot].storage == BOOT_SLOT_STORAGE_QSPI) {
+        return Boot_SlotQSPIStep(job);
+    }
+    if (job->data == NULL) {
+        return Boot_SlotEraseInternalStep(job);
+    }
+    if (job->addr >= job->end) {
+        return BOOT_SLOT_JOB_DONE;
+    }
+    uint32_t size = job->end - job->addr;
+    if (size > BOOT_SLOT_WRITE_STEP_SIZE) {
+        size = BOOT_SLOT_WRITE_STEP_SIZE;
+    }
+    if (Boot_SlotWriteInternal(job->addr, job->data, size) !=
+        ERROR_CODE_NO_ERROR) {
+        return BOOT_SLOT_JOB_ERROR;
+    }
+    job->addr += size;
+    job->data += size;
+    job->done += size;
+    job->blocks++;
+    return BOOT_SLOT_JOB_AGAIN;
+}
+
+bool Boot_SlotJobBusy(const BootSlotJob_t *job) {
+    return slot_region[job->slot].storage == BOOT_SLOT_STORAGE_QSPI &&
+           QSPI_FLASH_IsBusy(&QSPI_Flash);
+}
+
+// 阻塞执行到完成
+static BootErrorCode_t Boot_SlotJobRun(BootSlotJob_t *job) {
+    BootSlotJobState_t state;
+    do {
+        state = Boot_SlotJobStep(job);
+    } while (state == BOOT_SLOT_JOB_BUSY || state == BOOT_SLOT_JOB_AGAIN);
+    return (state == BOOT_SLOT_JOB_DONE) ? ERROR_CODE_NO_ERROR
+                                         : ERROR_CODE_FIRMWARE_FLASH_ERROR;
+}
+
+BootErrorCode_t Boot_SlotBeginUpdate(BootSlot_t slot, uint32_t length) {
+    BootSlotJob_t job;
+    BootErrorCode_t err = Boot_SlotEraseBegin(&job, slot, length);
+    if (err != ERROR_CODE_NO_ERROR) {
+        return err;
+    }
+    return Boot_SlotJobRun(&job);
+}
+
+BootErrorCode_t Boot_SlotWrite(BootSlot_t slot, uint32_t offset,
+                               const uint8_t *data, uint32_t len) {
+    BootSlotJob_t job;
+    BootErrorCode_t err = Boot_SlotWriteBegin(&job, slot, offset, data, len);
+    if (err != ERROR_CODE_NO_ERROR) {
+        return err;
+    }
+    return Boot_SlotJobRun(&job);
+}
+
+BootErrorCode_t Boot_SlotRead(BootSlot_t slot, uint32_t offset, uint8_t *data,
+                              uint32_t len) {
+    const BootSlotRegion_t *region = &slot_region[slot];
+
+    if (data == NULL || offset >= region->size || len > region->size - offset) {
+        return ERROR_CODE_FIRMWARE_INVALID_DATA;
+    }
+    if (region->storage == BOOT_SLOT_STORAGE_QSPI) {
+        if (!Boot_SlotStorageReady(slot) ||
+            QSPI_FLASH_Read(&QSPI_Flash, region->storageAddress + offset, data,
+                            len) != 0) {
+            return ERROR_CODE_FIRMWARE_FLASH_ERROR;
+        }
+        return ERROR_CODE_NO_ERROR;
+    }
+    memcpy(data, (const uint8_t *)(region->execAddress + offset), len);
+    return ERROR_CODE_NO_ERROR;
+}
+
+bool Boot_SlotReprogrammable(BootSlot_t slot) {
+    return slot_region[slot].storage == BOOT_SLOT_STORAGE_QSPI;
+}
+
+BootErrorCode_t Boot_SlotFinishUpdate(BootSlot_t slot, uint32_t version,
+                                      uint32_t length, uint32_t crc32) {
+    Boot_SlotMetaFinish(&slot_meta, slot, version, length, crc32);
+    Boot_SlotSetVerifyCount(0);
+    return Boot_SlotCommit();
+}
+
+bool Boot_SlotIsVerified(BootSlot_t slot) {
+    const BootSlotInfo_t *info = &slot_meta.slot[slot];
+#if BOOT_IMAGE_VERIFY_INTERVAL == 0
+    return false;
+#else
+    if (BOOT_SLOT_VERIFY_COUNT_WORD >= BOOT_IMAGE_VERIFY_INTERVAL) {
+        return false;
+    }
+    return info->valid &&
+           info->verifiedToken == Boot_SlotMetaToken(info->crc32, info->generation);
+#endif
+}
+
+BootErrorCode_t Boot_SlotSetVerified(BootSlot_t slot, uint32_t length,
+                                     uint32_t crc32) {
+    BootSlotInfo_t *info = &slot_meta.slot[slot];
+    uint32_t token = Boot_SlotMetaToken(crc32, info->generation);
+
+    Boot_SlotSetVerifyCount(0);
+    if (info->length == length && info->crc32 == crc32 &&
+        info->verifiedToken == token) {
+        return ERROR_CODE_NO_ERROR;
+    }
+    // 出厂固件没有经过升级流程，首次校验时补录信息
+    info->length = length;
+    info->crc32 = crc32;
+    info->verifiedToken = token;
+    return Boot_SlotCommit();
+}
+
+BootErrorCode_t Boot_SlotActivate(BootSlot_t slot) {
+    if (!Boot_SlotMetaActivate(&slot_meta, slot)) {
+        return ERROR_CODE_FIRMWARE_VERIFY_FAILED;
+    }
+    return Boot_SlotCommit();
+}
+
+BootErrorCode_t Boot_SlotRollback(void) {
+    BootSlot_t other = (BootSlot_t)(slot_meta.activeSlot ^ 1);
+    if (!Boot_SlotStorageReady(other) || !Boot_SlotMetaRollback(&slot_meta)) {
+        return ERROR_CODE_FIRMWARE_VERIFY_FAILED;
+    }
+    return Boot_SlotCommit();
+}
+
+BootErrorCode_t Boot_SlotConfirm(void) {
+    if (!Boot_SlotMetaConfirm(&slot_meta)) {
+        return ERROR_CODE_NO_ERROR;
+    }
+    return Boot_SlotCommit();
+}
+
+BootSlot_t Boot_SlotSelectBoot(void) {
+    BootSlotInfo_t *info = &slot_meta.slot[slot_meta.activeSlot];
+    if (info->valid && !info->confirmed) {
+        if (info->bootAttempts >= BOOT_SLOT_MAX_BOOT_ATTEMPTS) {
+            // 新固件多次启动都没有确认，回到上一个固件
+            Boot_SlotRollback();
+        } else {
+            info->bootAttempts++;
+            Boot_SlotCommit();
+        }
+    }
+    return Boot_SlotGetActive();
+}
+
+void Boot_SlotRequestConfirm(void) {
+    __HAL_RCC_BKPRAM_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    BOOT_SLOT_CONFIRM_WORD = BOOT_SLOT_CONFIRM_MAGIC;
+}
@@ -0,0 +1,242 @@
+#ifndef _BOOT_SLOT_H_
+#define _BOOT_SLOT_H_
+#include "boot.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 元数据记录标识 "ABSL"
+#define BOOT_SLOT_META_MAGIC 0x4C534241
+// app请求确认当前固件的标识，写在共享RAM中
+#define BOOT_SLOT_CONFIRM_MAGIC 0xC0FFEE01
+// 校验令牌混入的常量，避免全0/全1的记录恰好构成有效令牌
+#define BOOT_SLOT_TOKEN_MAGIC 0x5645524B
+
+// 固件槽
+typedef enum {
+    BOOT_SLOT_A = 0, // 片内出厂固件，只作回滚目标，boot不擦写
+    BOOT_SLOT_B,     // QSPI，每次升级都写入该槽
+    BOOT_SLOT_NUMS
+} BootSlot_t;
+
+// 槽所在的存储器
+typedef enum {
+    BOOT_SLOT_STORAGE_INTERNAL, // 片内flash
+    BOOT_SLOT_STORAGE_QSPI,     // QSPI flash
+} BootSlotStorage_t;
+
+// 槽的存储区域
+typedef struct {
+    BootSlotStorage_t storage;
+    uint32_t execAddress;    // 执行地址（QSPI为内存映射地址）
+    uint32_t storageAddress; // 编程地址（QSPI为芯片内偏移）
+    uint32_t size;
+} BootSlotRegion_t;
+
+// 单个槽的固件信息
+typedef struct {
+    uint32_t version;
+    uint32_t length;        // 固件长度，byte
+    uint32_t crc32;         // 固件CRC32
+    uint32_t generation;    // 写入代数，每次升级完成时更新
+    uint32_t verifiedToken; // 整镜像校验通过后由crc32和generation生成
+    uint8_t bootAttempts;   // 未确认时已尝试启动的次数
+    uint8_t confirmed;    // app运行正常后确认
+    uint8_t valid;        // 固件完整写入
+    uint8_t reserved;
+} BootSlotInfo_t;
+
+// 持久化的槽元数据记录，交替写入两个扇区，sequence大的为最新
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;
+    uint8_t activeSlot; // 当前启动槽
+    uint8_t reserved[3];
+    BootSlotInfo_t slot[BOOT_SLOT_NUMS];
+    uint32_t crc32; // 以上内容的CRC32
+} BootSlotMeta_t;
+
+// 分步擦写每一步的结果
+typedef enum {
+    BOOT_SLOT_JOB_BUSY,  // 上一步的硬件操作还没完成，本次没有推进
+    BOOT_SLOT_JOB_AGAIN, // 已推进一步，继续调用
+    BOOT_SLOT_JOB_DONE,  // 全部完成
+    BOOT_SLOT_JOB_ERROR, // 擦写失败或超时
+} BootSlotJobState_t;
+
+// 分步擦写的进度，由协作式任务反复调用Boot_SlotJobStep推进
+typedef struct {
+    BootSlot_t slot;
+    const uint8_t *data; // 下一步写入的数据，NULL为擦除
+    uint32_t addr;       // 下一步的存储地址
+    uint32_t end;        // 结束存储地址
+    uint32_t startTick;  // 当前硬件操作的开始时间
+    uint32_t timeout;    // 当前硬件操作的超时，毫秒
+    uint32_t pending;    // 已启动、还没确认完成的字节数
+    uint32_t done;       // 已完成的字节数
+    uint32_t blocks;     // 已完成的擦除块或编程页数
+} BootSlotJob_t;
+
+/**
+ * @brief 加载槽元数据，处理app的确认请求。在Boot_Init中调用
+ */
+void Boot_SlotInit(void);
+
+/**
+ * @brief 获取当前启动槽
+ */
+BootSlot_t Boot_SlotGetActive(void);
+
+/**
+ * @brief 获取候选槽，即升级写入的槽，固定为B槽
+ * @details B槽为当前启动槽时也覆盖它：先作废再擦写，中途失败时回滚到A槽
+ */
+BootSlot_t Boot_SlotGetCandidate(void);
+
+/**
+ * @brief 获取槽的固件信息
+ */
+const BootSlotInfo_t *Boot_SlotGetInfo(BootSlot_t slot);
+
+/**
+ * @brief 获取槽的存储区域
+ */
+const BootSlotRegion_t *Boot_SlotGetRegion(BootSlot_t slot);
+
+/**
+ * @brief 槽的擦除块大小：QSPI为4KB扇区，片内flash为扇区
+ */
+uint32_t Boot_SlotBlockSize(BootSlot_t slot);
+
+/**
+ * @brief 使槽可按执行地址读取（QSPI切换到内存映射模式）
+ * @return 槽的执行地址，失败返回0
+ */
+uint32_t Boot_SlotMap(BootSlot_t slot);
+
+/**
+ * @brief 开始升级槽：先在元数据中作废该槽，再擦除length范围
+ * @details 作废先于擦写提交，断电后半截固件不会被当作有效固件
+ */
+BootErrorCode_t Boot_SlotBeginUpdate(BootSlot_t slot, uint32_t length);
+
+/**
+ * @brief 向槽内偏移offset处写入数据
+ * @details 片内flash要求offset和len按BOOT_FLASH_WORD_SIZE对齐，这里不再检查；
+ *          上传时由boot.c的写合并缓冲凑成整闪存字
+ */
+BootErrorCode_t Boot_SlotWrite(BootSlot_t slot, uint32_t offset,
+                               const uint8_t *data, uint32_t len);
+
+/**
+ * @brief 从槽内偏移offset处读出数据
+ * @details QSPI用间接读，不经过内存映射和D-Cache，能读到刚编程的内容
+ */
+BootErrorCode_t Boot_SlotRead(BootSlot_t slot, uint32_t offset, uint8_t *data,
+                              uint32_t len);
+
+/**
+ * @brief 已编程的闪存字能否再次编程
+ * @details QSPI NOR flash只会把1写成0，可以；片内flash带ECC，同一个闪存字
+ *          只能编程一次
+ */
+bool Boot_SlotReprogrammable(BootSlot_t slot);
+
+/**
+ * @brief 在元数据中作废槽，并清空本次升级的擦除记录
+ * @details 按地址写入时先调用一次，之后用Boot_SlotEraseRangeBegin只擦除
+ *          有数据的块
+ */
+BootErrorCode_t Boot_SlotInvalidate(BootSlot_t slot);
+
+/**
+ * @brief 开始分步升级槽：立即在元数据中作废该槽，擦除由Boot_SlotJobStep完成
+ */
+BootErrorCode_t Boot_SlotEraseBegin(BootSlotJob_t *job, BootSlot_t slot,
+                                    uint32_t length);
+
+/**
+ * @brief 开始分步擦除槽内覆盖[offset, offset + len)的块
+ * @details 范围向外扩展到擦除块边界，Boot_SlotInvalidate之后已擦过的块跳过，
+ *          不会擦掉同一次升级中已写入的数据；与boot共用扇区的片内槽返回
+ *          ERROR_CODE_FIRMWARE_FLASH_ERROR
+ */
+BootErrorCode_t Boot_SlotEraseRangeBegin(BootSlotJob_t *job, BootSlot_t slot,
+                                         uint32_t offset, uint32_t len);
+
+/**
+ * @brief 开始分步写入，data在完成前必须保持有效
+ * @details 对齐要求同Boot_SlotWrite
+ */
+BootErrorCode_t Boot_SlotWriteBegin(BootSlotJob_t *job, BootSlot_t slot,
+                                    uint32_t offset, const uint8_t *data,
+                                    uint32_t len);
+
+/**
+ * @brief 推进一步：QSPI flash启动下一块擦除或下一页编程后立即返回，
+ *        片内flash擦除一个扇区或写入BOOT_SLOT_WRITE_STEP_SIZE字节
+ * @return BOOT_SLOT_JOB_BUSY时硬件完成会产生中断，可以睡眠等待
+ */
+BootSlotJobState_t Boot_SlotJobStep(BootSlotJob_t *job);
+
+/**
+ * @brief 擦写硬件是否还在执行上一步，中止任务后等它结束再访问flash
+ */
+bool Boot_SlotJobBusy(const BootSlotJob_t *job);
+
+/**
+ * @brief 完成升级，记录固件信息并标记槽有效
+ * @details 调用前须已对整镜像校验通过，同时更新写入代数并记录校验令牌
+ */
+BootErrorCode_t Boot_SlotFinishUpdate(BootSlot_t slot, uint32_t version,
+                                      uint32_t length, uint32_t crc32);
+
+/**
+ * @brief 槽的校验令牌是否有效，即当前代数的固件已做过整镜像校验
+ * @details 周期复查计数到达BOOT_IMAGE_VERIFY_INTERVAL时也返回false
+ */
+bool Boot_SlotIsVerified(BootSlot_t slot);
+
+/**
+ * @brief 整镜像校验通过后记录校验令牌，并清零周期复查计数
+ * @details 只有令牌或固件信息变化时才写flash，周期复查不产生擦写
+ */
+BootErrorCode_t Boot_SlotSetVerified(BootSlot_t slot, uint32_t length,
+                                     uint32_t crc32);
+
+/**
+ * @brief 切换启动槽，只改写元数据，不搬运固件
+ * @details 新槽启动次数清零且未确认，超过BOOT_SLOT_MAX_BOOT_ATTEMPTS仍未
+ *          确认时自动回滚
+ */
+BootErrorCode_t Boot_SlotActivate(BootSlot_t slot);
+
+/**
+ * @brief 回滚到另一个有效槽
+ */
+BootErrorCode_t Boot_SlotRollback(void);
+
+/**
+ * @brief 确认当前启动槽运行正常
+ */
+BootErrorCode_t Boot_SlotConfirm(void);
+
+/**
+ * @brief 启动前选择槽：累计未确认槽的启动次数，超限则回滚
+ * @return 本次应启动的槽
+ */
+BootSlot_t Boot_SlotSelectBoot(void);
+
+/**
+ * @brief 由app调用，请求boot在下次复位时确认当前槽
+ * @details 只写共享RAM，不访问flash，app在QSPI上原地执行时也可调用
+ */
+void Boot_SlotRequestConfirm(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
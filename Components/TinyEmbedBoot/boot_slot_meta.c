@@ -0,0 +1,65 @@
+#include "boot_slot_meta.h"
+#include <string.h>
+
+void Boot_SlotMetaDefault(BootSlotMeta_t *meta) {
+    memset(meta, 0, sizeof(BootSlotMeta_t));
+    meta->magic = BOOT_SLOT_META_MAGIC;
+    meta->activeSlot = BOOT_SLOT_A;
+    meta->slot[BOOT_SLOT_A].valid = 1;
+    meta->slot[BOOT_SLOT_A].confirmed = 1;
+}
+
+BootSlot_t Boot_SlotMetaCandidate(void) { return BOOT_SLOT_B; }
+
+uint32_t Boot_SlotMetaToken(uint32_t crc32, uint32_t generation) {
+    return crc32 ^ (generation * 0x9E3779B1) ^ BOOT_SLOT_TOKEN_MAGIC;
+}
+
+void Boot_SlotMetaInvalidate(BootSlotMeta_t *meta, BootSlot_t slot) {
+    memset(&meta->slot[slot], 0, sizeof(BootSlotInfo_t));
+}
+
+void Boot_SlotMetaFinish(BootSlotMeta_t *meta, BootSlot_t slot,
+                         uint32_t version, uint32_t length, uint32_t crc32) {
+    BootSlotInfo_t *info = &meta->slot[slot];
+
+    info->version = version;
+    info->length = length;
+    info->crc32 = crc32;
+    // 以本次提交的序号作为代数，单调且唯一
+    info->generation = meta->sequence + 1;
+    info->verifiedToken = Boot_SlotMetaToken(crc32, info->generation);
+    info->bootAttempts = 0;
+    info->confirmed = 0;
+    info->valid = 1;
+}
+
+bool Boot_SlotMetaActivate(BootSlotMeta_t *meta, BootSlot_t slot) {
+    if (slot >= BOOT_SLOT_NUMS || !meta->slot[slot].valid) {
+        return false;
+    }
+    if (meta->activeSlot != slot) {
+        meta->slot[slot].bootAttempts = 0;
+    }
+    meta->activeSlot = slot;
+    return true;
+}
+
+bool Boot_SlotMetaRollback(BootSlotMeta_t *meta) {
+    BootSlot_t other = (BootSlot_t)(meta->activeSlot ^ 1);
+    if (!meta->slot[other].valid) {
+        return false;
+    }
+    meta->activeSlot = other;
+    return true;
+}
+
+bool Boot_SlotMetaConfirm(BootSlotMeta_t *meta) {
+    BootSlotInfo_t *info = &meta->slot[meta->activeSlot];
+    if (info->confirmed) {
+        return false;
+    }
+    info->confirmed = 1;
+    info->bootAttempts = 0;
+    return true;
+}
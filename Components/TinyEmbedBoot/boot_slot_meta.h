@@ -0,0 +1,63 @@
+#ifndef _BOOT_SLOT_META_H_
+#define _BOOT_SLOT_META_H_
+#include "boot_slot.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 槽元数据的状态转换，只修改RAM中的记录，不访问flash，由boot_slot.c提交
+
+/**
+ * @brief 没有任何有效记录时的默认元数据：A槽为出厂固件，视为有效且已确认
+ */
+void Boot_SlotMetaDefault(BootSlotMeta_t *meta);
+
+/**
+ * @brief 升级写入的槽
+ * @details A槽为出厂固件，由烧录器写入，只作回滚目标；不论当前启动哪个槽，
+ *          升级都写B槽。A槽与boot共用扇区，boot无法擦除它
+ */
+BootSlot_t Boot_SlotMetaCandidate(void);
+
+/**
+ * @brief 由固件CRC32和写入代数生成校验令牌
+ */
+uint32_t Boot_SlotMetaToken(uint32_t crc32, uint32_t generation);
+
+/**
+ * @brief 作废槽，擦写前调用
+ */
+void Boot_SlotMetaInvalidate(BootSlotMeta_t *meta, BootSlot_t slot);
+
+/**
+ * @brief 记录升级完成的固件信息，标记槽有效、未确认
+ * @details 写入代数取下一次提交的序号
+ */
+void Boot_SlotMetaFinish(BootSlotMeta_t *meta, BootSlot_t slot,
+                         uint32_t version, uint32_t length, uint32_t crc32);
+
+/**
+ * @brief 切换启动槽
+ * @return 槽无效时返回false，记录不变
+ */
+bool Boot_SlotMetaActivate(BootSlotMeta_t *meta, BootSlot_t slot);
+
+/**
+ * @brief 切换到另一个槽
+ * @return 另一个槽无效时返回false，记录不变
+ */
+bool Boot_SlotMetaRollback(BootSlotMeta_t *meta);
+
+/**
+ * @brief 确认当前启动槽
+ * @return 记录有变化时返回true，需要提交
+ */
+bool Boot_SlotMetaConfirm(BootSlotMeta_t *meta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#include "boot_task.h"
+#include <stddef.h>
+
+// 运行中的任务，按启动顺序调度
+static BootTask_t *tasks[BOOT_TASK_MAX_NUMS];
+
+void Boot_TaskInit(BootTask_t *task, const char *name, BootTaskFunc_t func) {
+    task->name = name;
+    task->func = func;
+    task->lc = 0;
+    task->running = false;
+    task->abort = false;
+}
+
+bool Boot_TaskStart(BootTask_t *task) {
+    int8_t free_index = -1;
+    for (uint8_t i = 0; i < BOOT_TASK_MAX_NUMS; i++) {
+        if (tasks[i] == task) {
+            free_index = (int8_t)i;
+            break;
+        }
+        if (tasks[i] == NULL && free_index < 0) {
+            free_index = (int8_t)i;
+        }
+    }
+    if (free_index < 0) {
+        return false;
+    }
+    task->lc = 0;
+    task->abort = false;
+    task->running = true;
+    tasks[free_index] = task;
+    return true;
+}
+
+void Boot_TaskAbort(BootTask_t *task) {
+    if (task->running) {
+        task->abort = true;
+    }
+}
+
+bool Boot_TaskIsRunning(const BootTask_t *task) { return task->running; }
+
+bool Boot_TaskRunAll(void) {
+    bool yielded = false;
+    for (uint8_t i = 0; i < BOOT_TASK_MAX_NUMS; i++) {
+        BootTask_t *task = tasks[i];
+        if (task == NULL) {
+            continue;
+        }
+        BootTaskStatus_t status = task->func(task);
+        if (status == BOOT_TASK_EXITED) {
+            task->running = false;
+            task->abort = false;
+            tasks[i] = NULL;
+        } else if (status == BOOT_TASK_YIELDED) {
+            yielded = true;
+        }
+    }
+    return yielded;
+}
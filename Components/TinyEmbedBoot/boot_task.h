@@ -0,0 +1,117 @@
+#ifndef _BOOT_TASK_H_
+#define _BOOT_TASK_H_
+#include "boot_cfg.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 无栈协作式任务（protothread）
+ * 任务函数每次被调度时从上次让出的位置继续执行，续点用switch-case记录行号。
+ * 所有任务共用主循环的栈，局部变量在让出后不保留，需要跨让出的状态放在
+ * 静态变量或任务所属的结构体中；BOOT_TASK_xxx宏不能写在同一行，
+ * 也不能在任务函数内再使用switch包住让出点
+ */
+
+// 任务函数返回值
+typedef enum {
+    BOOT_TASK_WAITING = 0, // 等待硬件或事件，主循环可以睡眠到下一个中断
+    BOOT_TASK_YIELDED,     // 主动让出，还有工作，主循环不能睡眠
+    BOOT_TASK_EXITED,      // 已结束
+} BootTaskStatus_t;
+
+typedef struct BootTask_t BootTask_t;
+typedef BootTaskStatus_t (*BootTaskFunc_t)(BootTask_t *task);
+
+struct BootTask_t {
+    const char *name;
+    BootTaskFunc_t func;
+    uint16_t lc;           // 续点，0为从头开始
+    volatile bool running; // 是否在调度中
+    volatile bool abort;   // 请求中止，任务自行检查后收尾退出
+};
+
+#define BOOT_TASK_BEGIN(task)                                                  \
+    switch ((task)->lc) {                                                      \
+    case 0:
+
+#define BOOT_TASK_END(task)                                                    \
+    }                                                                          \
+    (task)->lc = 0;                                                            \
+    return BOOT_TASK_EXITED
+
+// 让出CPU，下一轮调度时立即继续
+#define BOOT_TASK_YIELD(task)                                                  \
+    do {                                                                       \
+        (task)->lc = __LINE__;                                                 \
+        return BOOT_TASK_YIELDED;                                              \
+    case __LINE__:;                                                            \
+    } while (0)
+
+// 让出CPU并允许主循环睡眠，下一个中断之后继续
+#define BOOT_TASK_WAIT(task)                                                   \
+    do {                                                                       \
+        (task)->lc = __LINE__;                                                 \
+        return BOOT_TASK_WAITING;                                              \
+    case __LINE__:;                                                            \
+    } while (0)
+
+// 等待条件成立，条件由中断改变时主循环可以睡眠
+// 第一次执行时直接落入续点检查条件，标注fallthrough避免-Wimplicit-fallthrough告警
+#define BOOT_TASK_WAIT_UNTIL(task, condition)                                  \
+    do {                                                                       \
+        (task)->lc = __LINE__;                                                 \
+        __attribute__((fallthrough));                                          \
+    case __LINE__:                                                             \
+        if (!(condition)) {                                                    \
+            return BOOT_TASK_WAITING;                                          \
+        }                                                                      \
+    } while (0)
+
+// 提前结束任务
+#define BOOT_TASK_EXIT(task)                                                   \
+    do {                                                                       \
+        (task)->lc = 0;                                                        \
+        return BOOT_TASK_EXITED;                                               \
+    } while (0)
+
+// 是否收到中止请求
+#define BOOT_TASK_ABORTED(task) ((task)->abort)
+
+/**
+ * @brief 初始化任务
+ * @param task 任务，由调用者分配
+ * @param name 任务名
+ * @param func 任务函数
+ */
+void Boot_TaskInit(BootTask_t *task, const char *name, BootTaskFunc_t func);
+
+/**
+ * @brief 从头启动任务，正在运行的任务会被重新开始
+ * @return 超过BOOT_TASK_MAX_NUMS个任务同时运行时返回false
+ */
+bool Boot_TaskStart(BootTask_t *task);
+
+/**
+ * @brief 请求任务中止，任务在下一个检查点收尾后退出
+ */
+void Boot_TaskAbort(BootTask_t *task);
+
+/**
+ * @brief 任务是否还在运行
+ */
+bool Boot_TaskIsRunning(const BootTask_t *task);
+
+/**
+ * @brief 依次调度所有运行中的任务一次，由主循环调用
+ * @return 有任务主动让出、需要立即再次调度时返回true，主循环不能睡眠
+ */
+bool Boot_TaskRunAll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
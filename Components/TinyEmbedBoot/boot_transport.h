@@ -0,0 +1,76 @@
+#ifndef _BOOT_TRANSPORT_H_
+#define _BOOT_TRANSPORT_H_
+#include "boot_cmd.h"
+#include <stdbool.h>
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BootTransport_t BootTransport_t;
+
+// 传输通道操作表，open/rx/tx_async/flush/set_busy可为NULL
+typedef struct {
+    // 打开通道，Boot_RegisterTransport时调用
+    bool (*open)(BootTransport_t *transport);
+    // 轮询读取，数据在中断中推送的通道为NULL
+    uint16_t (*rx)(BootTransport_t *transport, uint8_t *data, uint16_t size);
+    // 发送，数据拷贝或发送完成后返回
+    bool (*tx)(BootTransport_t *transport, const uint8_t *data,
+               uint16_t length);
+    // 零拷贝发送，data为Boot_TxBufAlloc分配的缓冲，返回true后由通道接管，
+    // 发送完成时调用Boot_TxBufRelease；返回false时缓冲仍归调用者
+    bool (*tx_async)(BootTransport_t *transport, uint8_t *data,
+                     uint16_t length);
+    // 等待已提交的数据发送完成，跳转app前调用
+    void (*flush)(BootTransport_t *transport);
+    // 单次能收发的最大字节数，决定协商的固件包大小
+    uint16_t (*max_packet)(BootTransport_t *transport);
+    // 收到完整命令帧到处理完成期间置忙，有硬件握手的通道（如SPI从机）用来让主机暂停
+    void (*set_busy)(BootTransport_t *transport, bool busy);
+} BootTransportOps_t;
+
+// 传输通道，每个通道有独立的解析器，半帧不会互相干扰
+struct BootTransport_t {
+    const char *name;
+    const BootTransportOps_t *ops;
+    void *context; // 通道私有数据，如驱动设备
+    // 解析器帧缓冲，由使用者分配，大小用COMMAND_PARSER_BUFFER_SIZE计算
+    uint8_t *rx_buffer;
+    uint16_t rx_buffer_size;
+    command_parser_t parser;
+};
+
+/**
+ * @brief 注册传输通道，可在Boot_Init前后调用
+ * @details 最先收到完整命令帧的通道建立会话，会话期间其他通道的数据被忽略，
+ *          应答只从会话通道发出
+ * @return 注册成功返回true，没有帧缓冲或超过BOOT_TRANSPORT_MAX_NUMS返回false
+ */
+bool Boot_RegisterTransport(BootTransport_t *transport);
+
+/**
+ * @brief 通道收到数据时调用（可在中断中）
+ * @param transport 收到数据的通道
+ * @param data 数据
+ * @param length 数据长度
+ */
+void Boot_TransportReceive(BootTransport_t *transport, const uint8_t *data,
+                           uint16_t length);
+
+/**
+ * @brief 通道发送完成时调用（可在中断中），向主循环投递BOOT_EVENT_TX_DONE
+ */
+void Boot_TransportTxDone(BootTransport_t *transport);
+
+/**
+ * @brief 获取当前会话所在的通道
+ * @return 还没有建立会话时返回NULL
+ */
+BootTransport_t *Boot_GetActiveTransport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
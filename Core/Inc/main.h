@@ -57,10 +57,14 @@ void Error_Handler(void);
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
+#define BOOT_UART_BAUDRATE 2000000
 #define LED_Pin GPIO_PIN_3
 #define LED_GPIO_Port GPIOE
 #define K1_Pin GPIO_PIN_13
 #define K1_GPIO_Port GPIOC
+#define K1_EXTI_IRQn EXTI15_10_IRQn
+#define SPI_RDY_Pin GPIO_PIN_11
+#define SPI_RDY_GPIO_Port GPIOB
 
 /* USER CODE BEGIN Private defines */
 
@@ -19,16 +19,27 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "crc.h"
+#include "dma.h"
 #include "gpio.h"
-// #include "quadspi.h"
+#include "quadspi.h"
+#include "spi.h"
+#include "tim.h"
+#include "usart.h"
 #include "usb_device.h"
 #include "usbd_cdc_if.h"
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "boot.h"
+#include "boot_image.h"
+#include "boot_slot.h"
+#include "boot_transport.h"
 #include "key_driver.h"
 #include "led_driver.h"
+#include "qspi_flash_driver.h"
+#include "spi_driver.h"
+#include "timpwm_driver.h"
+#include "uart_driver.h"
 #include <stdio.h>
 /* USER CODE END Includes */
 
@@ -41,6 +52,8 @@
 /* USER CODE BEGIN PD */
 #define BOOT
 // #define APP
+// 传输通道发送/等待发送完成的超时，毫秒
+#define BOOT_TRANSPORT_TX_TIMEOUT_MS 50
 
 /* USER CODE END PD */
 
@@ -54,6 +67,27 @@
 /* USER CODE BEGIN PV */
 LED_Device_t LED;
 KEY_Device_t K1;
+// 按键消抖和LED图案用的基本定时器，app没有初始化时按键和LED为轮询方式
+TIMPWM_Device_t KeyTimer;
+TIMPWM_Device_t LedTimer;
+QSPI_FLASH_Device_t QSPI_Flash;
+extern USBD_HandleTypeDef hUsbDeviceFS;
+UART_DMA_BUFFER UART_Device_t BootUART;
+// boot传输通道，最先收到完整命令帧的通道建立会话
+BootTransport_t BootCDC;
+BootTransport_t BootUARTLink;
+SPI_DMA_BUFFER SPI_SlaveDevice_t BootSPI;
+BootTransport_t BootSPILink;
+#if defined(BOOT)
+// 各通道解析器的帧缓冲，由CPU在中断中解析，放在默认的DTCM中
+static uint8_t boot_cdc_rx_buffer[COMMAND_PARSER_BUFFER_SIZE(FRAME_DATA_SIZE)];
+static uint8_t boot_uart_rx_buffer[COMMAND_PARSER_BUFFER_SIZE(FRAME_DATA_SIZE)];
+static uint8_t boot_spi_rx_buffer[COMMAND_PARSER_BUFFER_SIZE(FRAME_DATA_SIZE)];
+#endif
+#if defined(APP)
+// 固件头，长度、版本和CRC32由构建后脚本填写
+BOOT_IMAGE_HEADER_DEFINE();
+#endif
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -61,6 +95,17 @@ void SystemClock_Config(void);
 static void MPU_Config(void);
 bool CDC_transmit(uint8_t *data, uint16_t length);
 /* USER CODE BEGIN PFP */
+#if defined(BOOT)
+static void Boot_DeInitMPU(uint32_t handoff);
+static void Boot_DeInitCache(uint32_t handoff);
+static void Boot_DeInitQSPI(uint32_t handoff);
+static void Boot_DeInitCRC(uint32_t handoff);
+static void Boot_DeInitUSB(uint32_t handoff);
+static void Boot_DeInitUART(uint32_t handoff);
+static void Boot_DeInitSPI(uint32_t handoff);
+static void Boot_InitTransports(void);
+static void Boot_KeyEvent(KEY_State_t state);
+#endif
 
 /* USER CODE END PFP */
 
@@ -102,14 +147,37 @@ int main(void) {
 
     /* Initialize all configured peripherals */
     MX_GPIO_Init();
-    // MX_QUADSPI_Init();
+    MX_DMA_Init();
+    MX_QUADSPI_Init();
     MX_CRC_Init();
     MX_USB_DEVICE_Init();
+    MX_USART1_UART_Init();
+    MX_SPI2_Init();
+    MX_TIM6_Init();
+    MX_TIM7_Init();
 
     /* USER CODE BEGIN 2 */
     LED_InitDev(&LED, LED_GPIO_Port, LED_Pin, 1);
     KEY_InitDev(&K1, K1_GPIO_Port, K1_Pin, 1);
-    Boot_Init(CDC_transmit);
+    // 按键和LED由中断驱动，主循环空闲时可以睡眠
+    TIMPWM_InitDev(&KeyTimer, &htim6, 0);
+    TIMPWM_InitDev(&LedTimer, &htim7, 0);
+    KEY_EnableIT(&K1, &KeyTimer);
+    KEY_Set_EventCallback(&K1, Boot_KeyEvent);
+    LED_AttachTimer(&LED, &LedTimer);
+    QSPI_FLASH_InitDev(&QSPI_Flash, &hqspi);
+    UART_InitDev(&BootUART, &huart1);
+    SPI_SlaveInitDev(&BootSPI, &hspi2, SPI_RDY_GPIO_Port, SPI_RDY_Pin);
+    // 跳转app前按逆序关闭，USB最先断开，MPU最后关闭
+    Boot_RegisterDeInit(Boot_DeInitMPU);
+    Boot_RegisterDeInit(Boot_DeInitCache);
+    Boot_RegisterDeInit(Boot_DeInitQSPI);
+    Boot_RegisterDeInit(Boot_DeInitCRC);
+    Boot_RegisterDeInit(Boot_DeInitUSB);
+    Boot_RegisterDeInit(Boot_DeInitUART);
+    Boot_RegisterDeInit(Boot_DeInitSPI);
+    Boot_InitTransports();
+    Boot_Init(NULL);
 
     /* USER CODE END 2 */
 
@@ -120,6 +188,12 @@ int main(void) {
 
         /* USER CODE BEGIN 3 */
         Boot_ProcessStateMachine();
+        // 事件队列空时睡眠。关中断后检查，检查之后到来的中断仍会把WFI唤醒
+        __disable_irq();
+        if (Boot_IsIdle()) {
+            __WFI();
+        }
+        __enable_irq();
     }
     /* USER CODE END 3 */
 }
@@ -153,7 +227,12 @@ int main(void) {
     /* USER CODE END Init */
 
     /* Configure the system clock */
-    SystemClock_Config();
+    // boot保留了时钟树时跳过时钟配置
+    if (Boot_GetHandoff() & BOOT_HANDOFF_CLOCK) {
+        SystemCoreClockUpdate();
+    } else {
+        SystemClock_Config();
+    }
 
     /* USER CODE BEGIN SysInit */
 
@@ -161,10 +240,15 @@ int main(void) {
 
     /* Initialize all configured peripherals */
     MX_GPIO_Init();
-    MX_QUADSPI_Init();
+    // boot保留了内存映射模式时QSPI已可直接读取
+    if (!(Boot_GetHandoff() & BOOT_HANDOFF_QSPI_MMAP)) {
+        MX_QUADSPI_Init();
+    }
     /* USER CODE BEGIN 2 */
     LED_InitDev(&LED, LED_GPIO_Port, LED_Pin, 1);
     KEY_InitDev(&K1, K1_GPIO_Port, K1_Pin, 1);
+    // 运行正常，请求boot确认当前槽，避免被回滚
+    Boot_SlotRequestConfirm();
     printf("test");
     /* USER CODE END 2 */
 
@@ -235,6 +319,15 @@ void SystemClock_Config(void) {
 }
 
 /* USER CODE BEGIN 4 */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    KEY_EXTI_Callback(&K1, GPIO_Pin);
+}
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
+    KEY_TIM_Callback(&K1, htim);
+    LED_TIM_Callback(&LED, htim);
+}
+
 bool CDC_transmit(uint8_t *data, uint16_t length) {
     uint8_t ret = CDC_Transmit_FS(data, length);
     if (ret == USBD_OK) {
@@ -244,6 +337,197 @@ bool CDC_transmit(uint8_t *data, uint16_t length) {
     }
 }
 
+#if defined(BOOT)
+// USB CDC通道：上一包还在发送时等待，超时返回失败
+static bool Boot_CDCTx(BootTransport_t *transport, const uint8_t *data,
+                       uint16_t length) {
+    (void)transport;
+    uint32_t start = HAL_GetTick();
+    while (CDC_Transmit_FS((uint8_t *)data, length) == USBD_BUSY) {
+        if (HAL_GetTick() - start > BOOT_TRANSPORT_TX_TIMEOUT_MS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 发送池缓冲排队发送，不等待上一帧，发送完成时在CDC_TransmitCplt_FS中释放
+static bool Boot_CDCTxAsync(BootTransport_t *transport, uint8_t *data,
+                            uint16_t length) {
+    (void)transport;
+    return CDC_TransmitQueued_FS(data, length) == USBD_OK;
+}
+
+static void Boot_CDCFlush(BootTransport_t *transport) {
+    (void)transport;
+    uint32_t start = HAL_GetTick();
+    while (!CDC_IsTxIdle_FS() &&
+           HAL_GetTick() - start <= BOOT_TRANSPORT_TX_TIMEOUT_MS) {
+    }
+}
+
+static uint16_t Boot_CDCMaxPacket(BootTransport_t *transport) {
+    (void)transport;
+    // USB端点自动分包，不限制帧长
+    return FRAME_SIZE;
+}
+
+static const BootTransportOps_t boot_cdc_ops = {
+    .tx = Boot_CDCTx,
+    .tx_async = Boot_CDCTxAsync,
+    .flush = Boot_CDCFlush,
+    .max_packet = Boot_CDCMaxPacket,
+};
+
+// 串口通道：数据拷贝进DMA发送队列
+static bool Boot_UARTTx(BootTransport_t *transport, const uint8_t *data,
+                        uint16_t length) {
+    return UART_Transmit((UART_Device_t *)transport->context, (uint8_t *)data,
+                         length);
+}
+
+static void Boot_UARTFlush(BootTransport_t *transport) {
+    uint32_t start = HAL_GetTick();
+    while (!UART_IsTxIdle((UART_Device_t *)transport->context) &&
+           HAL_GetTick() - start <= BOOT_TRANSPORT_TX_TIMEOUT_MS) {
+    }
+}
+
+static uint16_t Boot_UARTMaxPacket(BootTransport_t *transport) {
+    (void)transport;
+    // 一帧必须能放进一个发送缓冲区
+    return UART_TX_BUFFER_SIZE;
+}
+
+static const BootTransportOps_t boot_uart_ops = {
+    .tx = Boot_UARTTx,
+    .flush = Boot_UARTFlush,
+    .max_packet = Boot_UARTMaxPacket,
+};
+
+// SPI从机通道：数据进入发送FIFO，由主机的下一次传输读走
+static bool Boot_SPITx(BootTransport_t *transport, const uint8_t *data,
+                       uint16_t length) {
+    return SPI_SlaveTransmit((SPI_SlaveDevice_t *)transport->context, data,
+                             length);
+}
+
+static void Boot_SPIFlush(BootTransport_t *transport) {
+    uint32_t start = HAL_GetTick();
+    while (!SPI_SlaveIsTxIdle((SPI_SlaveDevice_t *)transport->context) &&
+           HAL_GetTick() - start <= BOOT_TRANSPORT_TX_TIMEOUT_MS) {
+    }
+}
+
+static uint16_t Boot_SPIMaxPacket(BootTransport_t *transport) {
+    (void)transport;
+    // 发送FIFO能放下一个完整帧
+    return FRAME_SIZE;
+}
+
+static void Boot_SPISetBusy(BootTransport_t *transport, bool busy) {
+    SPI_SlaveSetBusy((SPI_SlaveDevice_t *)transport->context, busy);
+}
+
+static const BootTransportOps_t boot_spi_ops = {
+    .tx = Boot_SPITx,
+    .flush = Boot_SPIFlush,
+    .max_packet = Boot_SPIMaxPacket,
+    .set_busy = Boot_SPISetBusy,
+};
+
+static void Boot_SPIReceive(const uint8_t *data, uint16_t length) {
+    Boot_TransportReceive(&BootSPILink, data, length);
+}
+
+static void Boot_UARTReceive(const uint8_t *data, uint16_t length) {
+    Boot_TransportReceive(&BootUARTLink, data, length);
+}
+
+// 按键事件投递到boot事件队列
+static void Boot_KeyEvent(KEY_State_t state) {
+    Boot_EventPost(BOOT_EVENT_KEY, (uint8_t)state, 0);
+}
+
+static void Boot_InitTransports(void) {
+    BootCDC.name = "usb-cdc";
+    BootCDC.ops = &boot_cdc_ops;
+    BootCDC.rx_buffer = boot_cdc_rx_buffer;
+    BootCDC.rx_buffer_size = sizeof(boot_cdc_rx_buffer);
+    Boot_RegisterTransport(&BootCDC);
+
+    BootUARTLink.name = "uart1";
+    BootUARTLink.ops = &boot_uart_ops;
+    BootUARTLink.context = &BootUART;
+    BootUARTLink.rx_buffer = boot_uart_rx_buffer;
+    BootUARTLink.rx_buffer_size = sizeof(boot_uart_rx_buffer);
+    Boot_RegisterTransport(&BootUARTLink);
+    UART_Set_RxCallback(&BootUART, Boot_UARTReceive);
+
+    BootSPILink.name = "spi2";
+    BootSPILink.ops = &boot_spi_ops;
+    BootSPILink.context = &BootSPI;
+    BootSPILink.rx_buffer = boot_spi_rx_buffer;
+    BootSPILink.rx_buffer_size = sizeof(boot_spi_rx_buffer);
+    Boot_RegisterTransport(&BootSPILink);
+    SPI_SlaveSet_RxCallback(&BootSPI, Boot_SPIReceive);
+}
+
+// 跳转app前的外设反初始化
+// 关闭MPU后按默认存储映射访问，0x90000000的QSPI窗口可读可执行，
+// 保留内存映射模式时app可原地执行；app开启MPU时用同一份MPU_Config
+static void Boot_DeInitMPU(uint32_t handoff) {
+    (void)handoff;
+    HAL_MPU_Disable();
+}
+
+static void Boot_DeInitCache(uint32_t handoff) {
+    (void)handoff;
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        SCB_CleanInvalidateDCache();
+        SCB_DisableDCache();
+    }
+    if (SCB->CCR & SCB_CCR_IC_Msk) {
+        SCB_DisableICache();
+    }
+}
+
+static void Boot_DeInitQSPI(uint32_t handoff) {
+    if (handoff & BOOT_HANDOFF_QSPI_MMAP) {
+        // 保留内存映射模式，只关闭boot用到的中断
+        HAL_NVIC_DisableIRQ(QUADSPI_IRQn);
+        HAL_NVIC_DisableIRQ(MDMA_IRQn);
+    } else {
+        QSPI_FLASH_DeInitDev(&QSPI_Flash);
+    }
+}
+
+static void Boot_DeInitCRC(uint32_t handoff) {
+    (void)handoff;
+    HAL_CRC_DeInit(&hcrc);
+}
+
+static void Boot_DeInitUSB(uint32_t handoff) {
+    (void)handoff;
+    // 断开上拉后主机即认为设备拔出，app重新枚举时不会残留旧连接
+    USBD_Stop(&hUsbDeviceFS);
+    USBD_DeInit(&hUsbDeviceFS);
+}
+
+static void Boot_DeInitUART(uint32_t handoff) {
+    (void)handoff;
+    UART_DeInitDev(&BootUART);
+    HAL_NVIC_DisableIRQ(DMA1_Stream0_IRQn);
+    HAL_NVIC_DisableIRQ(DMA1_Stream1_IRQn);
+}
+
+static void Boot_DeInitSPI(uint32_t handoff) {
+    (void)handoff;
+    SPI_SlaveDeInitDev(&BootSPI);
+    HAL_NVIC_DisableIRQ(DMA1_Stream2_IRQn);
+    HAL_NVIC_DisableIRQ(DMA1_Stream3_IRQn);
+}
+#endif
 /* USER CODE END 4 */
 
 /* MPU Configuration */
@@ -268,6 +552,19 @@ void MPU_Config(void) {
     MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
     MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
 
+    HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+    /** Initializes and configures the Region and the memory to be protected
+     */
+    MPU_InitStruct.Number = MPU_REGION_NUMBER1;
+    MPU_InitStruct.BaseAddress = 0x90000000;
+    MPU_InitStruct.Size = MPU_REGION_SIZE_8MB;
+    MPU_InitStruct.SubRegionDisable = 0x0;
+    MPU_InitStruct.AccessPermission = MPU_REGION_PRIV_RO_URO;
+    MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_ENABLE;
+    MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    MPU_InitStruct.IsCacheable = MPU_ACCESS_CACHEABLE;
+
     HAL_MPU_ConfigRegion(&MPU_InitStruct);
     /* Enables the MPU */
     HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
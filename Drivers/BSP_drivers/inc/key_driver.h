@@ -14,6 +14,7 @@ extern "C" {
 
 #include "gpio.h"
 #include "stdio.h"
+#include "timpwm_driver.h"
 
 // key状态
 typedef enum {
@@ -22,6 +23,9 @@ typedef enum {
     KEY_State_DOWN,
 } KEY_State_t;
 
+// 中断模式下产生按键事件时的回调，在定时器中断中调用
+typedef void (*KEY_EventCallbackPointer)(KEY_State_t state);
+
 // KEY句柄信息
 typedef struct {
     GPIO_TypeDef *GPIOx;    // gpio端口，依赖hal库
@@ -30,13 +34,34 @@ typedef struct {
     KEY_State_t State;      // 当前状态
     KEY_State_t LastState;  // 上次状态
     uint32_t lastChangeTime; // 上次状态变化时间
+    // 中断模式：EXTI边沿重新启动消抖定时器，定时器到期时读取电平并产生事件
+    TIMPWM_Device_t *Debounce;    // 消抖定时器，NULL为轮询模式
+    volatile KEY_State_t Event;   // 中断中产生、尚未取走的事件
+    KEY_EventCallbackPointer event_callback; // 事件回调，可为NULL
 } KEY_Device_t;
 
 // 初始化
 void KEY_InitDev(KEY_Device_t *dev, GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
                  uint8_t pressDownLevel);
-// 状态查询
+/**
+ * @brief 切换到中断模式
+ * @param dev 按键句柄
+ * @param debounce 单脉冲模式的消抖定时器，周期即消抖时间
+ * @details 引脚需配置为双边沿EXTI，并在HAL_GPIO_EXTI_Callback和
+ *          HAL_TIM_PeriodElapsedCallback中分别调用KEY_EXTI_Callback和
+ *          KEY_TIM_Callback。开启时按键已按下也会产生一次按下事件
+ */
+void KEY_EnableIT(KEY_Device_t *dev, TIMPWM_Device_t *debounce);
+// 设置中断模式的事件回调，事件同时保留给KEY_GetState/KEY_GetEvent
+void KEY_Set_EventCallback(KEY_Device_t *dev,
+                           KEY_EventCallbackPointer eventcallback);
+// 状态查询，中断模式下只取走已产生的事件，不读引脚
 KEY_State_t KEY_GetState(KEY_Device_t *dev);
+// 取走中断中产生的事件，没有事件返回KEY_State_NONE
+KEY_State_t KEY_GetEvent(KEY_Device_t *dev);
+// 中断回调，不是本按键的引脚或定时器时直接返回
+void KEY_EXTI_Callback(KEY_Device_t *dev, uint16_t GPIO_Pin);
+void KEY_TIM_Callback(KEY_Device_t *dev, TIM_HandleTypeDef *htim);
 void KEY_DeInitDev(KEY_Device_t *dev);
 #ifdef __cplusplus
 }
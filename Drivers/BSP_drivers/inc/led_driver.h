@@ -14,6 +14,7 @@ extern "C" {
 
 #include "gpio.h"
 #include "stdio.h"
+#include "timpwm_driver.h"
 // led状态
 typedef struct LED_Device_t LED_Device_t;
 typedef enum LED_State_t LED_State_t;
@@ -21,7 +22,8 @@ enum LED_State_t {
     LED_State_OFF = 0,
     LED_State_ON,
     LED_State_TOGGLE,
-    LED_State_BLINK
+    LED_State_BLINK,
+    LED_State_PATTERN
 };
 
 // led句柄信息
@@ -30,6 +32,12 @@ struct LED_Device_t {
     uint16_t Pin;        // gpio引脚
     uint8_t ActiveLevel; // 有效电平，低电平亮设置为0，高电平亮设置为1
     LED_State_t State;
+    // 定时器模式：图案在定时器中断中逐位输出，主循环不需要反复调用
+    TIMPWM_Device_t *Timer;  // 图案节拍定时器，NULL时LED_Blink为轮询方式
+    uint32_t Pattern;        // 图案，bit0最先输出，1亮0灭
+    uint8_t PatternLength;   // 图案位数，1~32
+    volatile uint8_t PatternStep;
+    uint32_t StepMs;         // 每一位持续的时间
 };
 
 /**
@@ -47,6 +55,22 @@ void LED_On(LED_Device_t *dev);
 void LED_Off(LED_Device_t *dev);
 void LED_Toggle(LED_Device_t *dev);
 void LED_Blink(LED_Device_t *dev, uint32_t delay);
+
+/**
+ * @brief 绑定图案节拍定时器，之后LED_Blink和LED_SetPattern由定时器中断驱动
+ * @details 需要在HAL_TIM_PeriodElapsedCallback中调用LED_TIM_Callback
+ */
+void LED_AttachTimer(LED_Device_t *dev, TIMPWM_Device_t *timer);
+/**
+ * @brief 循环输出闪烁图案，图案和节拍都没有变化时不重新开始
+ * @param pattern 图案，bit0最先输出，1亮0灭，如0x5、长度8为快闪两次后熄灭
+ * @param length 图案位数，1~32
+ * @param step_ms 每一位持续的时间，毫秒
+ */
+void LED_SetPattern(LED_Device_t *dev, uint32_t pattern, uint8_t length,
+                    uint32_t step_ms);
+// 定时器中断回调，不是本LED的定时器时直接返回
+void LED_TIM_Callback(LED_Device_t *dev, TIM_HandleTypeDef *htim);
 // 状态查询
 uint8_t LED_GetState(LED_Device_t *dev);
 
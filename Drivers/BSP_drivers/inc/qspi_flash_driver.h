@@ -0,0 +1,134 @@
+// Header:
+// File Name: qspi_flash_driver.h
+// Author: DJS
+// Date: 2025年10月19日
+
+#ifndef _MY_QSPI_FLASH_H_
+#define _MY_QSPI_FLASH_H_
+
+#define USE_CUBEMX_QSPI 1 // 默认使用cubemx初始化quadspi
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "quadspi.h" //板级驱动和初始化
+#include "stdio.h"
+
+// W25Qxx系列NOR Flash命令字
+#define QSPI_FLASH_CMD_WRITE_ENABLE 0x06
+#define QSPI_FLASH_CMD_READ_SR1 0x05
+#define QSPI_FLASH_CMD_READ_SR2 0x35
+#define QSPI_FLASH_CMD_WRITE_SR2 0x31
+#define QSPI_FLASH_CMD_JEDEC_ID 0x9F
+#define QSPI_FLASH_CMD_QUAD_PAGE_PROGRAM 0x32 // 1-1-4页编程
+#define QSPI_FLASH_CMD_QUAD_IO_READ 0xEB      // 1-4-4快速读
+#define QSPI_FLASH_CMD_ERASE_4K 0x20
+#define QSPI_FLASH_CMD_ERASE_32K 0x52
+#define QSPI_FLASH_CMD_ERASE_64K 0xD8
+#define QSPI_FLASH_CMD_ENABLE_RESET 0x66
+#define QSPI_FLASH_CMD_RESET 0x99
+
+// 状态寄存器位
+#define QSPI_FLASH_SR1_BUSY 0x01 // 擦写进行中
+#define QSPI_FLASH_SR1_WEL 0x02  // 写使能锁存
+#define QSPI_FLASH_SR2_QE 0x02   // 四线使能
+
+// 存储结构
+#define QSPI_FLASH_PAGE_SIZE 256
+#define QSPI_FLASH_SECTOR_SIZE 0x1000   // 4KB擦除块
+#define QSPI_FLASH_BLOCK32_SIZE 0x8000  // 32KB擦除块
+#define QSPI_FLASH_BLOCK64_SIZE 0x10000 // 64KB擦除块
+// JEDEC ID容量字节的合理范围（64KB~2GB），芯片未焊接或无应答时读到0x00或0xFF
+#define QSPI_FLASH_CAPACITY_MIN 0x10
+#define QSPI_FLASH_CAPACITY_MAX 0x1F
+// 内存映射模式下的起始地址
+#define QSPI_FLASH_MEM_ADDRESS QSPI_BASE
+
+// 超时时间(ms)，取自W25Q64JV手册最大值
+#define QSPI_FLASH_TIMEOUT_CMD 100
+#define QSPI_FLASH_TIMEOUT_PAGE_PROGRAM 5
+#define QSPI_FLASH_TIMEOUT_ERASE_64K 2000
+
+// 前置声明 防止函数指针参数类型未定义
+typedef struct QSPI_FLASH_Device_t QSPI_FLASH_Device_t;
+
+// 异步擦写阶段
+typedef enum {
+    QSPI_FLASH_STAGE_IDLE = 0, // 空闲
+    QSPI_FLASH_STAGE_TX,       // MDMA正在向FIFO送数据
+    QSPI_FLASH_STAGE_TX_DONE,  // 数据已送完，等待启动自动轮询
+    QSPI_FLASH_STAGE_POLL,     // 硬件自动轮询BUSY位中
+} QSPI_FLASH_Stage_t;
+
+// QSPI Flash句柄信息
+struct QSPI_FLASH_Device_t {
+    QSPI_HandleTypeDef *hqspi;         // HAL库QSPI句柄
+    uint32_t jedecId;                  // 厂商ID<<16 | 类型<<8 | 容量
+    uint32_t flashSize;                // 容量，byte
+    volatile QSPI_FLASH_Stage_t stage; // 异步擦写阶段，自动轮询匹配后回到空闲
+    volatile uint8_t error;            // 异步操作出错
+    uint8_t memoryMapped;              // 是否处于内存映射模式
+};
+
+// MDMA句柄，供中断服务函数使用
+extern MDMA_HandleTypeDef hmdma_quadspi_fifo_th;
+
+/**
+ * @brief 初始化QSPI Flash：复位、读取ID、打开四线模式、配置MDMA
+ * @param dev 句柄
+ * @param hqspi 已初始化的HAL QSPI句柄
+ * @return 0成功 -1失败
+ */
+int32_t QSPI_FLASH_InitDev(QSPI_FLASH_Device_t *dev, QSPI_HandleTypeDef *hqspi);
+
+// 信息查询
+int32_t QSPI_FLASH_ReadID(QSPI_FLASH_Device_t *dev, uint32_t *id);
+uint8_t QSPI_FLASH_IsBusy(QSPI_FLASH_Device_t *dev);
+
+// 读
+int32_t QSPI_FLASH_Read(QSPI_FLASH_Device_t *dev, uint32_t addr, uint8_t *data,
+                        uint32_t size);
+
+/**
+ * @brief 启动一页编程，数据由MDMA送入FIFO，立即返回
+ * @details 发送完成后由QSPI_FLASH_IsBusy切换到中断式自动轮询，状态匹配中断
+ *          里回到空闲，CPU不参与轮询。data在完成前必须保持有效
+ * @param addr 页内起始地址，addr+size不能跨页
+ * @return 0成功 -1失败
+ */
+int32_t QSPI_FLASH_StartProgramPage(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                                    const uint8_t *data, uint32_t size);
+// 阻塞写，自动按页拆分
+int32_t QSPI_FLASH_Write(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                         const uint8_t *data, uint32_t size);
+
+/**
+ * @brief 启动单个擦除块，立即返回，完成情况由QSPI_FLASH_IsBusy查询
+ * @param blockSize 4KB/32KB/64KB之一，addr需按其对齐
+ */
+int32_t QSPI_FLASH_StartEraseBlock(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                                   uint32_t blockSize);
+/**
+ * @brief 获取擦除[addr, addr+size)时下一步应使用的最大擦除块
+ * @return 擦除块大小，按64KB/32KB/4KB贪心选取使擦除次数最少
+ */
+uint32_t QSPI_FLASH_GetEraseBlockSize(uint32_t addr, uint32_t size);
+// 阻塞擦除，范围按4KB向外扩展
+int32_t QSPI_FLASH_Erase(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                         uint32_t size);
+
+// 等待异步操作结束
+int32_t QSPI_FLASH_WaitReady(QSPI_FLASH_Device_t *dev, uint32_t timeout);
+
+// 内存映射模式，开启后可直接按QSPI_FLASH_MEM_ADDRESS读取或执行
+int32_t QSPI_FLASH_EnableMemoryMapped(QSPI_FLASH_Device_t *dev);
+int32_t QSPI_FLASH_DisableMemoryMapped(QSPI_FLASH_Device_t *dev);
+
+void QSPI_FLASH_DeInitDev(QSPI_FLASH_Device_t *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -13,6 +13,20 @@ extern "C" {
 #endif
 
 #include "spi.h" //板级驱动和初始化，如果有的话
+#include "stdbool.h"
+#include "string.h"
+
+// SPI从机传输块大小：主机每次拉低片选传输的字节数，也是DMA双缓冲的一半
+#define SPI_SLAVE_BLOCK_SIZE 256
+// 从机发送FIFO大小，2的幂，需能放下一个完整应答帧
+#define SPI_SLAVE_TX_FIFO_SIZE 4096
+// 没有数据可发时MISO上的填充字节，与帧头不同，解析器会跳过
+#define SPI_SLAVE_FILL_BYTE 0x00
+// 同时使用的SPI从机设备个数，用于HAL回调查找设备
+#define SPI_SLAVE_DEVICE_MAX_NUMS 1
+
+// DMA1/DMA2无法访问DTCM，设备结构体需用此属性放到D2 SRAM
+#define SPI_DMA_BUFFER __attribute__((section(".dma_buffer"), aligned(32)))
 
 // 前置声明 防止函数指针内参数类型未定义
 typedef struct SPI_Device_t SPI_Device_t;
@@ -35,6 +49,72 @@ void SPI_InitDev(SPI_Device_t *dev, SPI_HandleTypeDef *hspi);
 int32_t SPI_Transmit(SPI_Device_t *dev, uint8_t *data, uint32_t size);
 int32_t SPI_Receive(SPI_Device_t *dev, uint8_t *data, uint32_t size);
 int32_t SPI_Transmit_DMA(SPI_Device_t *dev, uint8_t *data, uint32_t size);
+
+// SPI从机（全双工循环DMA）
+// 主机以SPI_SLAVE_BLOCK_SIZE为单位传输，每块之前等待就绪引脚为高。
+// MOSI上是命令帧字节流，帧间用填充字节补齐；MISO上同样是应答字节流，
+// 没有应答时全为填充字节，应答最迟在入队后的第三个块中出现
+typedef struct SPI_SlaveDevice_t SPI_SlaveDevice_t;
+
+// 接收回调在中断中调用，每收完一块调用一次
+typedef void (*SPI_RxCallbackPointer)(const uint8_t *data, uint16_t size);
+
+struct SPI_SlaveDevice_t {
+    // DMA缓冲区放在最前面，保证32字节对齐（cache行）
+    // 循环DMA的前后两半即双缓冲：DMA传输一半时CPU处理另一半
+    uint8_t rx_buffer[2 * SPI_SLAVE_BLOCK_SIZE];
+    uint8_t tx_buffer[2 * SPI_SLAVE_BLOCK_SIZE];
+    uint8_t tx_fifo[SPI_SLAVE_TX_FIFO_SIZE];
+
+    SPI_HandleTypeDef *hspi;
+    // 就绪/忙引脚，高电平表示可以传输
+    GPIO_TypeDef *ready_port;
+    uint16_t ready_pin;
+
+    // 发送FIFO，tx_head入队，tx_tail由DMA回调取走
+    volatile uint16_t tx_head;
+    volatile uint16_t tx_tail;
+    volatile bool busy;
+    volatile uint32_t errors; // 上溢/下溢等错误次数，出错后重新启动传输
+
+    SPI_RxCallbackPointer rx_callback;
+};
+
+/**
+ * @brief 初始化SPI从机设备并启动全双工循环DMA
+ * @param dev 设备，需用SPI_DMA_BUFFER定义
+ * @param hspi 已由cubemx初始化的从机句柄，收发DMA均为循环模式
+ * @param ready_port 就绪引脚端口，为NULL时不使用握手
+ * @param ready_pin 就绪引脚
+ */
+void SPI_SlaveInitDev(SPI_SlaveDevice_t *dev, SPI_HandleTypeDef *hspi,
+                      GPIO_TypeDef *ready_port, uint16_t ready_pin);
+
+// 设置接收回调
+void SPI_SlaveSet_RxCallback(SPI_SlaveDevice_t *dev,
+                             SPI_RxCallbackPointer rxcallback);
+
+/**
+ * @brief 数据拷贝进发送FIFO，由主机后续的传输读走
+ * @return FIFO空间不足时返回false
+ */
+bool SPI_SlaveTransmit(SPI_SlaveDevice_t *dev, const uint8_t *data,
+                       uint16_t size);
+
+/**
+ * @brief 发送FIFO是否已经全部交给DMA
+ */
+bool SPI_SlaveIsTxIdle(SPI_SlaveDevice_t *dev);
+
+/**
+ * @brief 设置忙状态，忙时拉低就绪引脚，主机暂停传输
+ */
+void SPI_SlaveSetBusy(SPI_SlaveDevice_t *dev, bool busy);
+
+/**
+ * @brief 停止DMA并反初始化SPI
+ */
+void SPI_SlaveDeInitDev(SPI_SlaveDevice_t *dev);
 #ifdef __cplusplus
 }
 #endif
@@ -35,6 +35,21 @@ void TIMPWM_InitDev(TIMPWM_Device_t *dev, TIM_HandleTypeDef *htim, uint32_t chan
 void TIMPWM_Start(TIMPWM_Device_t *dev);
 void TIMPWM_SetCompara(TIMPWM_Device_t *dev, uint32_t compara);
 uint32_t TIMPWM_GetCompara(TIMPWM_Device_t *dev);
+
+// 以下为定时中断用法，基本定时器（如TIM6/TIM7）没有输出通道，channel填0即可
+/**
+ * @brief 设置更新中断周期
+ * @param ticks 周期，单位为定时器计数（预分频后的时钟），不能为0
+ */
+void TIMPWM_SetPeriod(TIMPWM_Device_t *dev, uint32_t ticks);
+/**
+ * @brief 计数清零并开启更新中断，已在运行时重新开始计时
+ * @details 单脉冲模式的定时器到期后自动停止，下次调用会重新启动
+ */
+void TIMPWM_StartIT(TIMPWM_Device_t *dev);
+void TIMPWM_StopIT(TIMPWM_Device_t *dev);
+// 停止并关闭定时器时钟和中断
+void TIMPWM_DeInitDev(TIMPWM_Device_t *dev);
 #ifdef __cplusplus
 }
 #endif
@@ -12,51 +12,94 @@
 extern "C" {
 #endif
 
+#include "stdbool.h"
 #include "stdio.h"
 #include "string.h"
 #include "usart.h"
 
-#define RX_BUFFER_SIZE 32
+// 循环DMA接收缓冲区大小，即接收环形缓冲区，2的幂
+#define UART_RX_BUFFER_SIZE 2048
+// 发送队列深度和单帧最大长度，发送数据拷贝到队列后立即返回
+#define UART_TX_QUEUE_NUMS 4
+#define UART_TX_BUFFER_SIZE 2080
+// 同时使用的串口设备个数，用于HAL回调查找设备
+#define UART_DEVICE_MAX_NUMS 2
+
+// DMA1/DMA2无法访问DTCM，设备结构体需用此属性放到D2 SRAM
+#define UART_DMA_BUFFER __attribute__((section(".dma_buffer"), aligned(32)))
 
 // 前置声明 防止函数指针参数类型未定义
 typedef struct UART_Device_t UART_Device_t;
 
 // 回调函数类型定义
-typedef void (*UART_RxCallbackPointer)(void);
+// 接收回调在中断中调用，data指向环形缓冲区内的连续数据
+typedef void (*UART_RxCallbackPointer)(const uint8_t *data, uint16_t size);
 typedef void (*UART_ErrorCallbackPointer)(void);
 
-// 函数指针类型定义
-typedef void (*UART_TransmitFunc)(UART_Device_t *, uint8_t *, uint16_t);
-typedef void (*UART_ReceiveFunc)(UART_Device_t *, uint8_t *, uint16_t);
-
 // UART设备结构体
 struct UART_Device_t {
+    // DMA缓冲区放在最前面，保证32字节对齐（cache行）
+    uint8_t rx_buffer[UART_RX_BUFFER_SIZE];
+    uint8_t tx_buffer[UART_TX_QUEUE_NUMS][UART_TX_BUFFER_SIZE];
+
     // 核心成员
     UART_HandleTypeDef *huart; // HAL库UART句柄
 
-    // 接收相关
-    uint8_t rx_byte;      // 单字节接收缓冲区
-    uint16_t rx_buffSize; // 多字节接收缓冲区大小
+    // 接收相关，rx_head由DMA位置决定，rx_tail为已读取位置
+    volatile uint16_t rx_head;
+    volatile uint16_t rx_tail;
+    volatile uint32_t rx_overflow; // 未及时读取被覆盖的次数
+
+    // 发送队列，tx_head入队，tx_tail为正在发送的帧
+    uint16_t tx_length[UART_TX_QUEUE_NUMS];
+    volatile uint8_t tx_head;
+    volatile uint8_t tx_tail;
+    volatile bool tx_busy;
 
     // 函数指针
     UART_RxCallbackPointer rx_callback;       // 接收回调函数指针
     UART_ErrorCallbackPointer error_callback; // 错误回调函数指针
-    UART_TransmitFunc transmit;               // 发送函数指针
-    UART_ReceiveFunc receive;                 // 接收函数指针
 };
-// 初始化函数
+
+/**
+ * @brief 初始化串口设备，启动循环DMA+空闲中断接收
+ * @param dev 设备，需用UART_DMA_BUFFER定义
+ * @param huart 已由cubemx初始化的串口句柄，接收DMA为循环模式
+ */
 void UART_InitDev(UART_Device_t *dev, UART_HandleTypeDef *huart);
+
 // 回调函数
+// 设置接收回调后数据在中断中直接交给回调，不再保留在环形缓冲区
 void UART_Set_RxCallback(UART_Device_t *dev, UART_RxCallbackPointer rxcallback);
 void UART_Set_ErrorCallback(UART_Device_t *dev,
                             UART_ErrorCallbackPointer errorcallback);
 
-// 传输
-void UART_Transmit(UART_Device_t *dev, uint8_t *data, uint16_t size);
-void UART_Receive_IT(UART_Device_t *dev, uint8_t *data, uint16_t size);
+/**
+ * @brief DMA发送，数据拷贝到发送队列后立即返回
+ * @return 队列已满或数据超过UART_TX_BUFFER_SIZE时返回false
+ */
+bool UART_Transmit(UART_Device_t *dev, const uint8_t *data, uint16_t size);
+
+/**
+ * @brief 发送队列是否已全部发送完成
+ */
+bool UART_IsTxIdle(UART_Device_t *dev);
+
+/**
+ * @brief 从接收环形缓冲区读取数据（未设置接收回调时使用）
+ * @return 实际读取的字节数
+ */
+uint16_t UART_Read(UART_Device_t *dev, uint8_t *data, uint16_t size);
+
+/**
+ * @brief 接收环形缓冲区中可读的字节数
+ */
+uint16_t UART_Available(UART_Device_t *dev);
 
-// 中断处理
-void UART_userIRQ_Handler(UART_Device_t *dev);
+/**
+ * @brief 停止DMA收发并反初始化串口
+ */
+void UART_DeInitDev(UART_Device_t *dev);
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,9 @@ void KEY_InitDev(KEY_Device_t *dev, GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
     dev->pressDownLevel = pressDownLevel;
     dev->State = KEY_State_UP;
     dev->LastState = KEY_State_UP;
+    dev->Debounce = NULL;
+    dev->Event = KEY_State_NONE;
+    dev->event_callback = NULL;
 
 #if (USE_CUBEMX_GPIO == 0)
     // 如果不使用cubemx初始化就要自己初始化
@@ -18,20 +21,74 @@ void KEY_InitDev(KEY_Device_t *dev, GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
 
 // 控制函数
 
+// 读取引脚电平对应的按键状态
+static KEY_State_t KEY_ReadLevel(KEY_Device_t *dev) {
+    GPIO_PinState pin_state = HAL_GPIO_ReadPin(dev->GPIOx, dev->Pin);
+    if ((pin_state == GPIO_PIN_SET && dev->pressDownLevel) ||
+        (pin_state == GPIO_PIN_RESET && !dev->pressDownLevel)) {
+        return KEY_State_DOWN;
+    }
+    return KEY_State_UP;
+}
+
+void KEY_EnableIT(KEY_Device_t *dev, TIMPWM_Device_t *debounce) {
+    if (dev == NULL || debounce == NULL)
+        return;
+    dev->Event = KEY_State_NONE;
+    dev->Debounce = debounce;
+    // 上电时已按下的按键没有边沿，直接启动一次消抖
+    if (KEY_ReadLevel(dev) != dev->State) {
+        TIMPWM_StartIT(dev->Debounce);
+    }
+}
+
+void KEY_EXTI_Callback(KEY_Device_t *dev, uint16_t GPIO_Pin) {
+    if (dev->Debounce == NULL || GPIO_Pin != dev->Pin)
+        return;
+    // 抖动期间每个边沿都重新计时，电平稳定一个定时周期后才判定
+    TIMPWM_StartIT(dev->Debounce);
+}
+
+void KEY_TIM_Callback(KEY_Device_t *dev, TIM_HandleTypeDef *htim) {
+    if (dev->Debounce == NULL || htim != dev->Debounce->htim)
+        return;
+    // 单脉冲定时器已自动停止，同步HAL句柄状态
+    TIMPWM_StopIT(dev->Debounce);
+    KEY_State_t current_state = KEY_ReadLevel(dev);
+    if (current_state != dev->State) {
+        dev->LastState = dev->State;
+        dev->State = current_state;
+        // 主循环来不及取走时只保留最新的事件
+        dev->Event = current_state;
+        if (dev->event_callback != NULL) {
+            dev->event_callback(current_state);
+        }
+    }
+}
+
+void KEY_Set_EventCallback(KEY_Device_t *dev,
+                           KEY_EventCallbackPointer eventcallback) {
+    dev->event_callback = eventcallback;
+}
+
+KEY_State_t KEY_GetEvent(KEY_Device_t *dev) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    KEY_State_t event = dev->Event;
+    dev->Event = KEY_State_NONE;
+    __set_PRIMASK(primask);
+    return event;
+}
+
 // 状态查询
 KEY_State_t KEY_GetState(KEY_Device_t *dev) {
+    if (dev->Debounce != NULL) {
+        return KEY_GetEvent(dev);
+    }
     // 获取当前时间
     uint32_t current_time = HAL_GetTick();
     // 读取当前物理状态
-    GPIO_PinState pin_state = HAL_GPIO_ReadPin(dev->GPIOx, dev->Pin);
-    // 临时存储按键状态
-    KEY_State_t current_state;
-    if ((pin_state == GPIO_PIN_SET && dev->pressDownLevel) ||
-        (pin_state == GPIO_PIN_RESET && !dev->pressDownLevel)) {
-        current_state = KEY_State_DOWN;
-    } else {
-        current_state = KEY_State_UP;
-    }
+    KEY_State_t current_state = KEY_ReadLevel(dev);
 
     if (dev->State != current_state) {
         // 消抖处理（20ms）
@@ -48,4 +105,10 @@ KEY_State_t KEY_GetState(KEY_Device_t *dev) {
 
     return KEY_State_NONE;
 }
-void KEY_DeInitDev(KEY_Device_t *dev) { HAL_GPIO_DeInit(dev->GPIOx, dev->Pin); }
\ No newline at end of file
+void KEY_DeInitDev(KEY_Device_t *dev) {
+    if (dev->Debounce != NULL) {
+        TIMPWM_DeInitDev(dev->Debounce);
+        dev->Debounce = NULL;
+    }
+    HAL_GPIO_DeInit(dev->GPIOx, dev->Pin);
+}
\ No newline at end of file
@@ -7,6 +7,11 @@ void LED_InitDev(LED_Device_t *dev, GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
     dev->GPIOx = GPIOx;
     dev->Pin = GPIO_Pin;
     dev->ActiveLevel = ActiveLevel;
+    dev->Timer = NULL;
+    dev->Pattern = 0;
+    dev->PatternLength = 0;
+    dev->PatternStep = 0;
+    dev->StepMs = 0;
 
 #if (USE_CUBEMX_GPIO == 0)
     // 如果不使用cubemx初始化就要自己初始化
@@ -17,34 +22,101 @@ void LED_InitDev(LED_Device_t *dev, GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin,
 }
 
 // 控制函数
+static void LED_Write(LED_Device_t *dev, uint8_t on) {
+    HAL_GPIO_WritePin(dev->GPIOx, dev->Pin,
+                      (GPIO_PinState)(((on != 0) == (dev->ActiveLevel != 0))
+                                          ? GPIO_PIN_SET
+                                          : GPIO_PIN_RESET));
+}
+// 手动控制时停止正在输出的图案
+static void LED_StopPattern(LED_Device_t *dev) {
+    if (dev->Timer != NULL &&
+        (dev->State == LED_State_BLINK || dev->State == LED_State_PATTERN)) {
+        TIMPWM_StopIT(dev->Timer);
+    }
+}
 void LED_On(LED_Device_t *dev) {
+    LED_StopPattern(dev);
     dev->State = LED_State_ON;
-    HAL_GPIO_WritePin(
-        dev->GPIOx, dev->Pin,
-        (GPIO_PinState)(dev->ActiveLevel ? GPIO_PIN_SET : GPIO_PIN_RESET));
+    LED_Write(dev, 1);
 }
 void LED_Off(LED_Device_t *dev) {
+    LED_StopPattern(dev);
     dev->State = LED_State_OFF;
-    HAL_GPIO_WritePin(
-        dev->GPIOx, dev->Pin,
-        (GPIO_PinState)(dev->ActiveLevel ? GPIO_PIN_RESET : GPIO_PIN_SET));
+    LED_Write(dev, 0);
 }
 void LED_Toggle(LED_Device_t *dev) {
+    LED_StopPattern(dev);
     dev->State = LED_State_TOGGLE;
     HAL_GPIO_TogglePin(dev->GPIOx, dev->Pin);
 }
 void LED_Blink(LED_Device_t *dev, uint32_t delay_ms) {
+    if (dev->Timer != NULL) {
+        // 亮灭各delay_ms，由定时器驱动
+        LED_SetPattern(dev, 0x1, 2, delay_ms);
+        dev->State = LED_State_BLINK;
+        return;
+    }
     dev->State = LED_State_BLINK;
     static uint32_t startTime;
     uint32_t currentTime;
     currentTime = HAL_GetTick();
     if (currentTime - startTime > delay_ms) {
-        LED_Toggle(dev);
+        HAL_GPIO_TogglePin(dev->GPIOx, dev->Pin);
         startTime = HAL_GetTick();
     }
 }
 
+void LED_AttachTimer(LED_Device_t *dev, TIMPWM_Device_t *timer) {
+    if (dev == NULL)
+        return;
+    dev->Timer = timer;
+}
+
+void LED_SetPattern(LED_Device_t *dev, uint32_t pattern, uint8_t length,
+                    uint32_t step_ms) {
+    if (dev->Timer == NULL || length == 0 || length > 32 || step_ms == 0)
+        return;
+    if ((dev->State == LED_State_BLINK || dev->State == LED_State_PATTERN) &&
+        dev->Pattern == pattern && dev->PatternLength == length &&
+        dev->StepMs == step_ms) {
+        return;
+    }
+    TIMPWM_StopIT(dev->Timer);
+    dev->Pattern = pattern;
+    dev->PatternLength = length;
+    dev->PatternStep = 0;
+    dev->StepMs = step_ms;
+    dev->State = LED_State_PATTERN;
+    // 16位自动重装载，超出时按最长周期
+    uint32_t ticks = step_ms * (TIM_BASE_TICK_HZ / 1000U);
+    if (ticks > 0x10000U) {
+        ticks = 0x10000U;
+    }
+    TIMPWM_SetPeriod(dev->Timer, ticks);
+    // 第一位立即输出，之后每个更新中断输出下一位
+    LED_Write(dev, (pattern & 0x1U) != 0);
+    TIMPWM_StartIT(dev->Timer);
+}
+
+void LED_TIM_Callback(LED_Device_t *dev, TIM_HandleTypeDef *htim) {
+    if (dev->Timer == NULL || htim != dev->Timer->htim)
+        return;
+    uint8_t step = dev->PatternStep + 1;
+    if (step >= dev->PatternLength) {
+        step = 0;
+    }
+    dev->PatternStep = step;
+    LED_Write(dev, (dev->Pattern >> step) & 0x1U);
+}
+
 // 状态查询
 uint8_t LED_GetState(LED_Device_t *dev) { return dev->State; }
 
-void LED_DeInitDev(LED_Device_t *dev) { HAL_GPIO_DeInit(dev->GPIOx, dev->Pin); }
\ No newline at end of file
+void LED_DeInitDev(LED_Device_t *dev) {
+    if (dev->Timer != NULL) {
+        TIMPWM_DeInitDev(dev->Timer);
+        dev->Timer = NULL;
+    }
+    HAL_GPIO_DeInit(dev->GPIOx, dev->Pin);
+}
\ No newline at end of file
@@ -0,0 +1,462 @@
+#include "qspi_flash_driver.h"
+
+MDMA_HandleTypeDef hmdma_quadspi_fifo_th;
+
+// HAL回调中使用的当前设备，H750只有一个QUADSPI
+static QSPI_FLASH_Device_t *qspi_flash_dev = NULL;
+
+// 命令模板：单线指令，24位地址，其余按需修改
+static void QSPI_FLASH_CommandInit(QSPI_CommandTypeDef *cmd,
+                                   uint32_t instruction) {
+    cmd->Instruction = instruction;
+    cmd->InstructionMode = QSPI_INSTRUCTION_1_LINE;
+    cmd->Address = 0;
+    cmd->AddressMode = QSPI_ADDRESS_NONE;
+    cmd->AddressSize = QSPI_ADDRESS_24_BITS;
+    cmd->AlternateBytes = 0;
+    cmd->AlternateByteMode = QSPI_ALTERNATE_BYTES_NONE;
+    cmd->AlternateBytesSize = QSPI_ALTERNATE_BYTES_8_BITS;
+    cmd->DummyCycles = 0;
+    cmd->DataMode = QSPI_DATA_NONE;
+    cmd->NbData = 0;
+    cmd->DdrMode = QSPI_DDR_MODE_DISABLE;
+    cmd->DdrHoldHalfCycle = QSPI_DDR_HHC_ANALOG_DELAY;
+    cmd->SIOOMode = QSPI_SIOO_INST_EVERY_CMD;
+}
+
+// 间接模式操作前退出内存映射
+static int32_t QSPI_FLASH_Prepare(QSPI_FLASH_Device_t *dev) {
+    if (dev->stage != QSPI_FLASH_STAGE_IDLE) {
+        return -1;
+    }
+    if (dev->memoryMapped) {
+        return QSPI_FLASH_DisableMemoryMapped(dev);
+    }
+    return 0;
+}
+
+static int32_t QSPI_FLASH_SendCommand(QSPI_FLASH_Device_t *dev,
+                                      uint32_t instruction) {
+    QSPI_CommandTypeDef cmd;
+    QSPI_FLASH_CommandInit(&cmd, instruction);
+    HAL_StatusTypeDef status =
+        HAL_QSPI_Command(dev->hqspi, &cmd, QSPI_FLASH_TIMEOUT_CMD);
+    return (status == HAL_OK) ? 0 : -1;
+}
+
+// 读取状态寄存器读命令的自动轮询配置
+static void QSPI_FLASH_PollingInit(QSPI_CommandTypeDef *cmd,
+                                   QSPI_AutoPollingTypeDef *cfg, uint32_t mask,
+                                   uint32_t match) {
+    QSPI_FLASH_CommandInit(cmd, QSPI_FLASH_CMD_READ_SR1);
+    cmd->DataMode = QSPI_DATA_1_LINE;
+    cmd->NbData = 1;
+    cfg->Match = match;
+    cfg->Mask = mask;
+    cfg->MatchMode = QSPI_MATCH_MODE_AND;
+    cfg->StatusBytesSize = 1;
+    cfg->Interval = 0x10;
+    cfg->AutomaticStop = QSPI_AUTOMATIC_STOP_ENABLE;
+}
+
+// 阻塞等待状态位，由QSPI硬件轮询，CPU只等待匹配标志
+static int32_t QSPI_FLASH_AutoPoll(QSPI_FLASH_Device_t *dev, uint32_t mask,
+                                   uint32_t match, uint32_t timeout) {
+    QSPI_CommandTypeDef cmd;
+    QSPI_AutoPollingTypeDef cfg;
+    QSPI_FLASH_PollingInit(&cmd, &cfg, mask, match);
+    HAL_StatusTypeDef status =
+        HAL_QSPI_AutoPolling(dev->hqspi, &cmd, &cfg, timeout);
+    return (status == HAL_OK) ? 0 : -1;
+}
+
+// 中断式自动轮询BUSY位，匹配后在HAL_QSPI_StatusMatchCallback中回到空闲
+static int32_t QSPI_FLASH_StartPollReady(QSPI_FLASH_Device_t *dev) {
+    QSPI_CommandTypeDef cmd;
+    QSPI_AutoPollingTypeDef cfg;
+    QSPI_FLASH_PollingInit(&cmd, &cfg, QSPI_FLASH_SR1_BUSY, 0);
+    dev->stage = QSPI_FLASH_STAGE_POLL;
+    if (HAL_QSPI_AutoPolling_IT(dev->hqspi, &cmd, &cfg) != HAL_OK) {
+        dev->stage = QSPI_FLASH_STAGE_IDLE;
+        dev->error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+static int32_t QSPI_FLASH_WriteEnable(QSPI_FLASH_Device_t *dev) {
+    if (QSPI_FLASH_SendCommand(dev, QSPI_FLASH_CMD_WRITE_ENABLE) != 0) {
+        return -1;
+    }
+    return QSPI_FLASH_AutoPoll(dev, QSPI_FLASH_SR1_WEL, QSPI_FLASH_SR1_WEL,
+                               QSPI_FLASH_TIMEOUT_CMD);
+}
+
+static int32_t QSPI_FLASH_Reset(QSPI_FLASH_Device_t *dev) {
+    if (QSPI_FLASH_SendCommand(dev, QSPI_FLASH_CMD_ENABLE_RESET) != 0 ||
+        QSPI_FLASH_SendCommand(dev, QSPI_FLASH_CMD_RESET) != 0) {
+        return -1;
+    }
+    // 复位恢复时间tRST最大30us
+    HAL_Delay(1);
+    return QSPI_FLASH_AutoPoll(dev, QSPI_FLASH_SR1_BUSY, 0,
+                               QSPI_FLASH_TIMEOUT_CMD);
+}
+
+// 打开SR2的QE位，否则IO2/IO3仍是WP#/HOLD#
+static int32_t QSPI_FLASH_EnableQuad(QSPI_FLASH_Device_t *dev) {
+    QSPI_CommandTypeDef cmd;
+    uint8_t sr2 = 0;
+
+    QSPI_FLASH_CommandInit(&cmd, QSPI_FLASH_CMD_READ_SR2);
+    cmd.DataMode = QSPI_DATA_1_LINE;
+    cmd.NbData = 1;
+    if (HAL_QSPI_Command(dev->hqspi, &cmd, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK ||
+        HAL_QSPI_Receive(dev->hqspi, &sr2, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK) {
+        return -1;
+    }
+    if (sr2 & QSPI_FLASH_SR2_QE) {
+        return 0;
+    }
+
+    if (QSPI_FLASH_WriteEnable(dev) != 0) {
+        return -1;
+    }
+    sr2 |= QSPI_FLASH_SR2_QE;
+    QSPI_FLASH_CommandInit(&cmd, QSPI_FLASH_CMD_WRITE_SR2);
+    cmd.DataMode = QSPI_DATA_1_LINE;
+    cmd.NbData = 1;
+    if (HAL_QSPI_Command(dev->hqspi, &cmd, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK ||
+        HAL_QSPI_Transmit(dev->hqspi, &sr2, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK) {
+        return -1;
+    }
+    return QSPI_FLASH_AutoPoll(dev, QSPI_FLASH_SR1_BUSY, 0,
+                               QSPI_FLASH_TIMEOUT_CMD);
+}
+
+// 配置QSPI发送FIFO的MDMA通道，每次FIFO阈值触发搬运一个阈值长度
+static int32_t QSPI_FLASH_MDMA_Init(QSPI_FLASH_Device_t *dev) {
+    __HAL_RCC_MDMA_CLK_ENABLE();
+
+    hmdma_quadspi_fifo_th.Instance = MDMA_Channel0;
+    hmdma_quadspi_fifo_th.Init.Request = MDMA_REQUEST_QUADSPI_FIFO_TH;
+    hmdma_quadspi_fifo_th.Init.TransferTriggerMode = MDMA_BUFFER_TRANSFER;
+    hmdma_quadspi_fifo_th.Init.Priority = MDMA_PRIORITY_HIGH;
+    hmdma_quadspi_fifo_th.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+    hmdma_quadspi_fifo_th.Init.SourceInc = MDMA_SRC_INC_BYTE;
+    hmdma_quadspi_fifo_th.Init.DestinationInc = MDMA_DEST_INC_DISABLE;
+    hmdma_quadspi_fifo_th.Init.SourceDataSize = MDMA_SRC_DATASIZE_BYTE;
+    hmdma_quadspi_fifo_th.Init.DestDataSize = MDMA_DEST_DATASIZE_BYTE;
+    hmdma_quadspi_fifo_th.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+    hmdma_quadspi_fifo_th.Init.BufferTransferLength =
+        dev->hqspi->Init.FifoThreshold;
+    hmdma_quadspi_fifo_th.Init.SourceBurst = MDMA_SOURCE_BURST_SINGLE;
+    hmdma_quadspi_fifo_th.Init.DestBurst = MDMA_DEST_BURST_SINGLE;
+    hmdma_quadspi_fifo_th.Init.SourceBlockAddressOffset = 0;
+    hmdma_quadspi_fifo_th.Init.DestBlockAddressOffset = 0;
+    if (HAL_MDMA_Init(&hmdma_quadspi_fifo_th) != HAL_OK) {
+        return -1;
+    }
+    __HAL_LINKDMA(dev->hqspi, hmdma, hmdma_quadspi_fifo_th);
+
+    HAL_NVIC_SetPriority(MDMA_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(MDMA_IRQn);
+    HAL_NVIC_SetPriority(QUADSPI_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(QUADSPI_IRQn);
+    return 0;
+}
+
+int32_t QSPI_FLASH_InitDev(QSPI_FLASH_Device_t *dev,
+                           QSPI_HandleTypeDef *hqspi) {
+    // 设备句柄是否有效，如果是无效指针就退出
+    if (dev == NULL || hqspi == NULL)
+        return -1;
+    dev->hqspi = hqspi;
+    dev->jedecId = 0;
+    dev->flashSize = 0;
+    dev->stage = QSPI_FLASH_STAGE_IDLE;
+    dev->error = 0;
+    dev->memoryMapped = 0;
+    qspi_flash_dev = dev;
+
+#if (USE_CUBEMX_QSPI == 0)
+    // 如果不使用cubemx初始化就要自己初始化
+    // 初始化代码
+#endif
+
+    if (hqspi->hmdma == NULL && QSPI_FLASH_MDMA_Init(dev) != 0) {
+        return -1;
+    }
+    if (QSPI_FLASH_Reset(dev) != 0) {
+        return -1;
+    }
+    if (QSPI_FLASH_ReadID(dev, &dev->jedecId) != 0) {
+        return -1;
+    }
+    // 容量字节为2的幂次，超出范围说明没有读到芯片
+    uint8_t capacity = dev->jedecId & 0xFF;
+    if (capacity < QSPI_FLASH_CAPACITY_MIN ||
+        capacity > QSPI_FLASH_CAPACITY_MAX) {
+        return -1;
+    }
+    dev->flashSize = 1UL << capacity;
+    return QSPI_FLASH_EnableQuad(dev);
+}
+
+int32_t QSPI_FLASH_ReadID(QSPI_FLASH_Device_t *dev, uint32_t *id) {
+    QSPI_CommandTypeDef cmd;
+    uint8_t buf[3];
+
+    if (QSPI_FLASH_Prepare(dev) != 0) {
+        return -1;
+    }
+    QSPI_FLASH_CommandInit(&cmd, QSPI_FLASH_CMD_JEDEC_ID);
+    cmd.DataMode = QSPI_DATA_1_LINE;
+    cmd.NbData = sizeof(buf);
+    if (HAL_QSPI_Command(dev->hqspi, &cmd, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK ||
+        HAL_QSPI_Receive(dev->hqspi, buf, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK) {
+        return -1;
+    }
+    *id = ((uint32_t)buf[0] << 16) | ((uint32_t)buf[1] << 8) | buf[2];
+    return 0;
+}
+
+uint8_t QSPI_FLASH_IsBusy(QSPI_FLASH_Device_t *dev) {
+    switch (dev->stage) {
+    case QSPI_FLASH_STAGE_IDLE:
+        return 0;
+    case QSPI_FLASH_STAGE_TX_DONE:
+        // 数据已全部移入Flash，切到硬件自动轮询等待页编程结束
+        QSPI_FLASH_StartPollReady(dev);
+        return (dev->stage != QSPI_FLASH_STAGE_IDLE);
+    default:
+        return 1;
+    }
+}
+
+int32_t QSPI_FLASH_Read(QSPI_FLASH_Device_t *dev, uint32_t addr, uint8_t *data,
+                        uint32_t size) {
+    QSPI_CommandTypeDef cmd;
+
+    if (size == 0) {
+        return 0;
+    }
+    if (QSPI_FLASH_Prepare(dev) != 0) {
+        return -1;
+    }
+    QSPI_FLASH_CommandInit(&cmd, QSPI_FLASH_CMD_QUAD_IO_READ);
+    cmd.Address = addr;
+    cmd.AddressMode = QSPI_ADDRESS_4_LINES;
+    // M7-M0=0xFF，不进入连续读模式
+    cmd.AlternateBytes = 0xFF;
+    cmd.AlternateByteMode = QSPI_ALTERNATE_BYTES_4_LINES;
+    cmd.DummyCycles = 4;
+    cmd.DataMode = QSPI_DATA_4_LINES;
+    cmd.NbData = size;
+    if (HAL_QSPI_Command(dev->hqspi, &cmd, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK ||
+        HAL_QSPI_Receive(dev->hqspi, data, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK) {
+        return -1;
+    }
+    return 0;
+}
+
+int32_t QSPI_FLASH_StartProgramPage(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                                    const uint8_t *data, uint32_t size) {
+    QSPI_CommandTypeDef cmd;
+
+    if (size == 0 || size > QSPI_FLASH_PAGE_SIZE ||
+        (addr % QSPI_FLASH_PAGE_SIZE) + size > QSPI_FLASH_PAGE_SIZE) {
+        return -1;
+    }
+    if (QSPI_FLASH_Prepare(dev) != 0 || QSPI_FLASH_WriteEnable(dev) != 0) {
+        return -1;
+    }
+
+    QSPI_FLASH_CommandInit(&cmd, QSPI_FLASH_CMD_QUAD_PAGE_PROGRAM);
+    cmd.Address = addr;
+    cmd.AddressMode = QSPI_ADDRESS_1_LINE;
+    cmd.DataMode = QSPI_DATA_4_LINES;
+    cmd.NbData = size;
+    if (HAL_QSPI_Command(dev->hqspi, &cmd, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK) {
+        return -1;
+    }
+
+    // MDMA直接读内存，开启D-Cache时要先把数据写回
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        uint32_t start = (uint32_t)data & ~0x1FUL;
+        SCB_CleanDCache_by_Addr((uint32_t *)start,
+                                (int32_t)(size + ((uint32_t)data - start)));
+    }
+
+    dev->error = 0;
+    dev->stage = QSPI_FLASH_STAGE_TX;
+    if (HAL_QSPI_Transmit_DMA(dev->hqspi, (uint8_t *)data) != HAL_OK) {
+        dev->stage = QSPI_FLASH_STAGE_IDLE;
+        return -1;
+    }
+    return 0;
+}
+
+int32_t QSPI_FLASH_Write(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                         const uint8_t *data, uint32_t size) {
+    while (size > 0) {
+        // 每次最多写到当前页末尾
+        uint32_t chunk = QSPI_FLASH_PAGE_SIZE - (addr % QSPI_FLASH_PAGE_SIZE);
+        if (chunk > size) {
+            chunk = size;
+        }
+        if (QSPI_FLASH_StartProgramPage(dev, addr, data, chunk) != 0 ||
+            QSPI_FLASH_WaitReady(dev, QSPI_FLASH_TIMEOUT_PAGE_PROGRAM + 1) !=
+                0) {
+            return -1;
+        }
+        addr += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+int32_t QSPI_FLASH_StartEraseBlock(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                                   uint32_t blockSize) {
+    QSPI_CommandTypeDef cmd;
+    uint32_t instruction;
+
+    switch (blockSize) {
+    case QSPI_FLASH_SECTOR_SIZE:
+        instruction = QSPI_FLASH_CMD_ERASE_4K;
+        break;
+    case QSPI_FLASH_BLOCK32_SIZE:
+        instruction = QSPI_FLASH_CMD_ERASE_32K;
+        break;
+    case QSPI_FLASH_BLOCK64_SIZE:
+        instruction = QSPI_FLASH_CMD_ERASE_64K;
+        break;
+    default:
+        return -1;
+    }
+    if ((addr & (blockSize - 1)) != 0) {
+        return -1;
+    }
+    if (QSPI_FLASH_Prepare(dev) != 0 || QSPI_FLASH_WriteEnable(dev) != 0) {
+        return -1;
+    }
+
+    QSPI_FLASH_CommandInit(&cmd, instruction);
+    cmd.Address = addr;
+    cmd.AddressMode = QSPI_ADDRESS_1_LINE;
+    if (HAL_QSPI_Command(dev->hqspi, &cmd, QSPI_FLASH_TIMEOUT_CMD) != HAL_OK) {
+        return -1;
+    }
+    dev->error = 0;
+    return QSPI_FLASH_StartPollReady(dev);
+}
+
+uint32_t QSPI_FLASH_GetEraseBlockSize(uint32_t addr, uint32_t size) {
+    if ((addr & (QSPI_FLASH_BLOCK64_SIZE - 1)) == 0 &&
+        size >= QSPI_FLASH_BLOCK64_SIZE) {
+        return QSPI_FLASH_BLOCK64_SIZE;
+    }
+    if ((addr & (QSPI_FLASH_BLOCK32_SIZE - 1)) == 0 &&
+        size >= QSPI_FLASH_BLOCK32_SIZE) {
+        return QSPI_FLASH_BLOCK32_SIZE;
+    }
+    return QSPI_FLASH_SECTOR_SIZE;
+}
+
+int32_t QSPI_FLASH_Erase(QSPI_FLASH_Device_t *dev, uint32_t addr,
+                         uint32_t size) {
+    uint32_t end = (addr + size + QSPI_FLASH_SECTOR_SIZE - 1) &
+                   ~(QSPI_FLASH_SECTOR_SIZE - 1);
+    addr &= ~(QSPI_FLASH_SECTOR_SIZE - 1);
+
+    while (addr < end) {
+        uint32_t blockSize = QSPI_FLASH_GetEraseBlockSize(addr, end - addr);
+        if (QSPI_FLASH_StartEraseBlock(dev, addr, blockSize) != 0 ||
+            QSPI_FLASH_WaitReady(dev, QSPI_FLASH_TIMEOUT_ERASE_64K) != 0) {
+            return -1;
+        }
+        addr += blockSize;
+    }
+    return 0;
+}
+
+int32_t QSPI_FLASH_WaitReady(QSPI_FLASH_Device_t *dev, uint32_t timeout) {
+    uint32_t tickstart = HAL_GetTick();
+    while (QSPI_FLASH_IsBusy(dev)) {
+        if (HAL_GetTick() - tickstart > timeout) {
+            HAL_QSPI_Abort(dev->hqspi);
+            dev->stage = QSPI_FLASH_STAGE_IDLE;
+            return -1;
+        }
+    }
+    return dev->error ? -1 : 0;
+}
+
+int32_t QSPI_FLASH_EnableMemoryMapped(QSPI_FLASH_Device_t *dev) {
+    QSPI_CommandTypeDef cmd;
+    QSPI_MemoryMappedTypeDef cfg;
+
+    if (dev->memoryMapped) {
+        return 0;
+    }
+    if (QSPI_FLASH_Prepare(dev) != 0) {
+        return -1;
+    }
+    QSPI_FLASH_CommandInit(&cmd, QSPI_FLASH_CMD_QUAD_IO_READ);
+    cmd.AddressMode = QSPI_ADDRESS_4_LINES;
+    cmd.AlternateBytes = 0xFF;
+    cmd.AlternateByteMode = QSPI_ALTERNATE_BYTES_4_LINES;
+    cmd.DummyCycles = 4;
+    cmd.DataMode = QSPI_DATA_4_LINES;
+    cfg.TimeOutActivation = QSPI_TIMEOUT_COUNTER_DISABLE;
+    cfg.TimeOutPeriod = 0;
+    if (HAL_QSPI_MemoryMapped(dev->hqspi, &cmd, &cfg) != HAL_OK) {
+        return -1;
+    }
+    dev->memoryMapped = 1;
+    return 0;
+}
+
+int32_t QSPI_FLASH_DisableMemoryMapped(QSPI_FLASH_Device_t *dev) {
+    if (!dev->memoryMapped) {
+        return 0;
+    }
+    if (HAL_QSPI_Abort(dev->hqspi) != HAL_OK) {
+        return -1;
+    }
+    dev->memoryMapped = 0;
+    return 0;
+}
+
+void QSPI_FLASH_DeInitDev(QSPI_FLASH_Device_t *dev) {
+    HAL_QSPI_Abort(dev->hqspi);
+    HAL_NVIC_DisableIRQ(QUADSPI_IRQn);
+    HAL_NVIC_DisableIRQ(MDMA_IRQn);
+    if (dev->hqspi->hmdma == &hmdma_quadspi_fifo_th) {
+        HAL_MDMA_DeInit(&hmdma_quadspi_fifo_th);
+        dev->hqspi->hmdma = NULL;
+    }
+    HAL_QSPI_DeInit(dev->hqspi);
+    dev->stage = QSPI_FLASH_STAGE_IDLE;
+    dev->memoryMapped = 0;
+    qspi_flash_dev = NULL;
+}
+
+// HAL回调
+void HAL_QSPI_TxCpltCallback(QSPI_HandleTypeDef *hqspi) {
+    if (qspi_flash_dev != NULL && qspi_flash_dev->hqspi == hqspi) {
+        qspi_flash_dev->stage = QSPI_FLASH_STAGE_TX_DONE;
+    }
+}
+void HAL_QSPI_StatusMatchCallback(QSPI_HandleTypeDef *hqspi) {
+    if (qspi_flash_dev != NULL && qspi_flash_dev->hqspi == hqspi) {
+        qspi_flash_dev->stage = QSPI_FLASH_STAGE_IDLE;
+    }
+}
+void HAL_QSPI_ErrorCallback(QSPI_HandleTypeDef *hqspi) {
+    if (qspi_flash_dev != NULL && qspi_flash_dev->hqspi == hqspi) {
+        qspi_flash_dev->error = 1;
+        qspi_flash_dev->stage = QSPI_FLASH_STAGE_IDLE;
+    }
+}
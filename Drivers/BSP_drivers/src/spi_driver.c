@@ -26,4 +26,176 @@ void SPI_InitDev(SPI_Device_t *dev, SPI_HandleTypeDef *hspi) {
     // 不使用cubemx初始化
     // 初始化代码
 #endif
-}
\ No newline at end of file
+}
+
+// SPI从机
+// HAL回调通过句柄查找设备
+static SPI_SlaveDevice_t *spi_slave_devices[SPI_SLAVE_DEVICE_MAX_NUMS];
+
+static SPI_SlaveDevice_t *SPI_SlaveFindDev(SPI_HandleTypeDef *hspi) {
+    for (uint32_t i = 0; i < SPI_SLAVE_DEVICE_MAX_NUMS; i++) {
+        if (spi_slave_devices[i] != NULL && spi_slave_devices[i]->hspi == hspi) {
+            return spi_slave_devices[i];
+        }
+    }
+    return NULL;
+}
+
+// 开启D-cache时，DMA缓冲区需要维护一致性，缓冲区均按cache行对齐
+static void SPI_CleanDCache(void *addr, uint32_t size) {
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        SCB_CleanDCache_by_Addr((uint32_t *)addr, size);
+    }
+}
+static void SPI_InvalidateDCache(void *addr, uint32_t size) {
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        SCB_InvalidateDCache_by_Addr((uint32_t *)addr, size);
+    }
+}
+
+static void SPI_SlaveUpdateReady(SPI_SlaveDevice_t *dev, bool ready) {
+    if (dev->ready_port != NULL) {
+        HAL_GPIO_WritePin(dev->ready_port, dev->ready_pin,
+                          ready ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    }
+}
+
+// 从发送FIFO取数据填满一半发送缓冲区，不足的部分补填充字节
+static void SPI_SlaveFillTx(SPI_SlaveDevice_t *dev, uint8_t half) {
+    uint8_t *block = &dev->tx_buffer[half * SPI_SLAVE_BLOCK_SIZE];
+    uint16_t tail = dev->tx_tail;
+    uint16_t count = (uint16_t)((dev->tx_head - tail) & (SPI_SLAVE_TX_FIFO_SIZE - 1));
+    uint16_t i = 0;
+
+    if (count > SPI_SLAVE_BLOCK_SIZE) {
+        count = SPI_SLAVE_BLOCK_SIZE;
+    }
+    for (; i < count; i++) {
+        block[i] = dev->tx_fifo[tail];
+        tail = (tail + 1) & (SPI_SLAVE_TX_FIFO_SIZE - 1);
+    }
+    memset(&block[i], SPI_SLAVE_FILL_BYTE, SPI_SLAVE_BLOCK_SIZE - i);
+    dev->tx_tail = tail;
+    SPI_CleanDCache(block, SPI_SLAVE_BLOCK_SIZE);
+}
+
+// 启动全双工循环DMA，两半发送缓冲区先各填一次
+static void SPI_SlaveStart(SPI_SlaveDevice_t *dev) {
+    SPI_SlaveFillTx(dev, 0);
+    SPI_SlaveFillTx(dev, 1);
+    if (HAL_SPI_TransmitReceive_DMA(dev->hspi, dev->tx_buffer, dev->rx_buffer,
+                                    2 * SPI_SLAVE_BLOCK_SIZE) != HAL_OK) {
+        dev->errors++;
+        SPI_SlaveUpdateReady(dev, false);
+        return;
+    }
+    SPI_SlaveUpdateReady(dev, !dev->busy);
+}
+
+// 处理DMA刚传输完的一半：交出接收数据，重新填充发送数据
+static void SPI_SlaveBlockDone(SPI_HandleTypeDef *hspi, uint8_t half) {
+    SPI_SlaveDevice_t *dev = SPI_SlaveFindDev(hspi);
+    if (dev == NULL) {
+        return;
+    }
+    uint8_t *block = &dev->rx_buffer[half * SPI_SLAVE_BLOCK_SIZE];
+    SPI_InvalidateDCache(block, SPI_SLAVE_BLOCK_SIZE);
+    if (dev->rx_callback != NULL) {
+        dev->rx_callback(block, SPI_SLAVE_BLOCK_SIZE);
+    }
+    SPI_SlaveFillTx(dev, half);
+}
+
+void SPI_SlaveInitDev(SPI_SlaveDevice_t *dev, SPI_HandleTypeDef *hspi,
+                      GPIO_TypeDef *ready_port, uint16_t ready_pin) {
+    // 设备句柄是否有效，如果是无效指针就退出
+    if (dev == NULL)
+        return;
+
+    // 设备在D2 SRAM的NOLOAD段中，上电不清零，逐项初始化
+    dev->hspi = hspi;
+    dev->ready_port = ready_port;
+    dev->ready_pin = ready_pin;
+    dev->tx_head = 0;
+    dev->tx_tail = 0;
+    dev->busy = false;
+    dev->errors = 0;
+    dev->rx_callback = NULL;
+
+    for (uint32_t i = 0; i < SPI_SLAVE_DEVICE_MAX_NUMS; i++) {
+        if (spi_slave_devices[i] == NULL || spi_slave_devices[i] == dev) {
+            spi_slave_devices[i] = dev;
+            break;
+        }
+    }
+    SPI_SlaveStart(dev);
+}
+
+void SPI_SlaveSet_RxCallback(SPI_SlaveDevice_t *dev,
+                             SPI_RxCallbackPointer rxcallback) {
+    dev->rx_callback = rxcallback;
+}
+
+bool SPI_SlaveTransmit(SPI_SlaveDevice_t *dev, const uint8_t *data,
+                       uint16_t size) {
+    if (dev == NULL || size == 0) {
+        return false;
+    }
+    // 只有发送端写tx_head，DMA回调只写tx_tail
+    uint16_t head = dev->tx_head;
+    uint16_t used = (uint16_t)((head - dev->tx_tail) & (SPI_SLAVE_TX_FIFO_SIZE - 1));
+    if (size > SPI_SLAVE_TX_FIFO_SIZE - 1 - used) {
+        return false;
+    }
+    uint16_t first = SPI_SLAVE_TX_FIFO_SIZE - head;
+    if (first > size) {
+        first = size;
+    }
+    memcpy(&dev->tx_fifo[head], data, first);
+    memcpy(dev->tx_fifo, data + first, size - first);
+    __DMB();
+    dev->tx_head = (head + size) & (SPI_SLAVE_TX_FIFO_SIZE - 1);
+    return true;
+}
+
+bool SPI_SlaveIsTxIdle(SPI_SlaveDevice_t *dev) {
+    return dev->tx_head == dev->tx_tail;
+}
+
+void SPI_SlaveSetBusy(SPI_SlaveDevice_t *dev, bool busy) {
+    dev->busy = busy;
+    SPI_SlaveUpdateReady(dev, !busy && dev->hspi->State != HAL_SPI_STATE_READY);
+}
+
+void SPI_SlaveDeInitDev(SPI_SlaveDevice_t *dev) {
+    SPI_SlaveUpdateReady(dev, false);
+    HAL_SPI_Abort(dev->hspi);
+    HAL_SPI_DeInit(dev->hspi);
+    for (uint32_t i = 0; i < SPI_SLAVE_DEVICE_MAX_NUMS; i++) {
+        if (spi_slave_devices[i] == dev) {
+            spi_slave_devices[i] = NULL;
+        }
+    }
+}
+
+// HAL回调
+void HAL_SPI_TxRxHalfCpltCallback(SPI_HandleTypeDef *hspi) {
+    SPI_SlaveBlockDone(hspi, 0);
+}
+
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi) {
+    SPI_SlaveBlockDone(hspi, 1);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi) {
+    SPI_SlaveDevice_t *dev = SPI_SlaveFindDev(hspi);
+    if (dev == NULL) {
+        return;
+    }
+    // 上溢/下溢后HAL已停止传输，块边界可能已错位，丢弃未发送的数据后重新启动
+    dev->errors++;
+    SPI_SlaveUpdateReady(dev, false);
+    HAL_SPI_Abort(hspi);
+    dev->tx_tail = dev->tx_head;
+    SPI_SlaveStart(dev);
+}
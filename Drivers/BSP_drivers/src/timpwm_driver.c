@@ -10,6 +10,23 @@ uint32_t TIMPWM_GetCompara(TIMPWM_Device_t *dev) {
     ret = __HAL_TIM_GET_COMPARE(dev->htim, dev->channel);
     return ret;
 }
+void TIMPWM_SetPeriod(TIMPWM_Device_t *dev, uint32_t ticks) {
+    __HAL_TIM_SET_AUTORELOAD(dev->htim, ticks - 1);
+    __HAL_TIM_SET_COUNTER(dev->htim, 0);
+}
+void TIMPWM_StartIT(TIMPWM_Device_t *dev) {
+    // 先停止，HAL句柄回到READY状态才能再次启动
+    HAL_TIM_Base_Stop_IT(dev->htim);
+    __HAL_TIM_SET_COUNTER(dev->htim, 0);
+    // 初始化时产生的更新事件会留下标志，不清除会立即进入一次中断
+    __HAL_TIM_CLEAR_FLAG(dev->htim, TIM_FLAG_UPDATE);
+    HAL_TIM_Base_Start_IT(dev->htim);
+}
+void TIMPWM_StopIT(TIMPWM_Device_t *dev) { HAL_TIM_Base_Stop_IT(dev->htim); }
+void TIMPWM_DeInitDev(TIMPWM_Device_t *dev) {
+    HAL_TIM_Base_Stop_IT(dev->htim);
+    HAL_TIM_Base_DeInit(dev->htim);
+}
 void TIMPWM_InitDev(TIMPWM_Device_t *dev, TIM_HandleTypeDef *htim,
                     uint32_t channel) {
     // 设备句柄是否有效，如果是无效指针就退出
@@ -2,14 +2,101 @@
 #include "stdlib.h"
 #include "string.h"
 
+// HAL回调通过句柄查找设备
+static UART_Device_t *uart_devices[UART_DEVICE_MAX_NUMS];
+
+static UART_Device_t *UART_FindDev(UART_HandleTypeDef *huart) {
+    for (uint32_t i = 0; i < UART_DEVICE_MAX_NUMS; i++) {
+        if (uart_devices[i] != NULL && uart_devices[i]->huart == huart) {
+            return uart_devices[i];
+        }
+    }
+    return NULL;
+}
+
+// 开启D-cache时，DMA缓冲区需要维护一致性
+static void UART_CleanDCache(const void *addr, uint32_t size) {
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        SCB_CleanDCache_by_Addr((uint32_t *)((uint32_t)addr & ~0x1FU),
+                                size + ((uint32_t)addr & 0x1FU));
+    }
+}
+static void UART_InvalidateDCache(const void *addr, uint32_t size) {
+    if (SCB->CCR & SCB_CCR_DC_Msk) {
+        SCB_InvalidateDCache_by_Addr((uint32_t *)((uint32_t)addr & ~0x1FU),
+                                     size + ((uint32_t)addr & 0x1FU));
+    }
+}
+
+// 启动循环DMA+空闲中断接收
+static void UART_StartReceive(UART_Device_t *dev) {
+    dev->rx_head = 0;
+    dev->rx_tail = 0;
+    HAL_UARTEx_ReceiveToIdle_DMA(dev->huart, dev->rx_buffer,
+                                 UART_RX_BUFFER_SIZE);
+}
+
+// 启动队尾帧的DMA发送，调用时需关中断或在中断中
+static void UART_StartTransmit(UART_Device_t *dev) {
+    if (dev->tx_busy || dev->tx_tail == dev->tx_head) {
+        return;
+    }
+    uint8_t slot = dev->tx_tail % UART_TX_QUEUE_NUMS;
+    dev->tx_busy = true;
+    if (HAL_UART_Transmit_DMA(dev->huart, dev->tx_buffer[slot],
+                              dev->tx_length[slot]) != HAL_OK) {
+        // 发送失败丢弃该帧，避免队列卡死
+        dev->tx_busy = false;
+        dev->tx_tail++;
+    }
+}
+
 // 传输函数
-void UART_Transmit(UART_Device_t *dev, uint8_t *data, uint16_t size) {
-    // 板级串口发送函数
-    HAL_UART_Transmit(dev->huart, data, size, HAL_MAX_DELAY);
+bool UART_Transmit(UART_Device_t *dev, const uint8_t *data, uint16_t size) {
+    if (dev == NULL || size == 0 || size > UART_TX_BUFFER_SIZE) {
+        return false;
+    }
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if ((uint8_t)(dev->tx_head - dev->tx_tail) >= UART_TX_QUEUE_NUMS) {
+        __set_PRIMASK(primask);
+        return false;
+    }
+    uint8_t slot = dev->tx_head % UART_TX_QUEUE_NUMS;
+    __set_PRIMASK(primask);
+
+    // 入队的槽只有发送端会写，拷贝时不需要关中断
+    memcpy(dev->tx_buffer[slot], data, size);
+    dev->tx_length[slot] = size;
+    UART_CleanDCache(dev->tx_buffer[slot], size);
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    dev->tx_head++;
+    UART_StartTransmit(dev);
+    __set_PRIMASK(primask);
+    return true;
+}
+
+bool UART_IsTxIdle(UART_Device_t *dev) {
+    return !dev->tx_busy && dev->tx_tail == dev->tx_head;
 }
-void UART_Receive_IT(UART_Device_t *dev, uint8_t *data, uint16_t size) {
-    // 板级串口中断接收函数
-    HAL_UART_Receive_IT(dev->huart, data, size);
+
+uint16_t UART_Available(UART_Device_t *dev) {
+    return (uint16_t)((dev->rx_head - dev->rx_tail) & (UART_RX_BUFFER_SIZE - 1));
+}
+
+uint16_t UART_Read(UART_Device_t *dev, uint8_t *data, uint16_t size) {
+    uint16_t count = 0;
+    uint16_t head = dev->rx_head;
+    uint16_t tail = dev->rx_tail;
+
+    while (count < size && tail != head) {
+        data[count++] = dev->rx_buffer[tail];
+        tail = (tail + 1) & (UART_RX_BUFFER_SIZE - 1);
+    }
+    dev->rx_tail = tail;
+    return count;
 }
 
 // 设置回调函数
@@ -28,19 +115,100 @@ void UART_InitDev(UART_Device_t *dev, UART_HandleTypeDef *huart) {
     if (dev == NULL)
         return;
 
+    // 设备在D2 SRAM的NOLOAD段中，上电不清零，逐项初始化
     dev->huart = huart; // hal句柄
-    dev->rx_byte = 0;
-    dev->rx_buffSize = RX_BUFFER_SIZE;
+    dev->rx_overflow = 0;
+    dev->tx_head = 0;
+    dev->tx_tail = 0;
+    dev->tx_busy = false;
+    dev->rx_callback = NULL;
+    dev->error_callback = NULL;
 
 #if (USE_CUBEMX_UART == 0)
     // 如果不使用cubemx初始化就要自己初始化
     // 初始化代码
 #endif
-    // 启动接收中断
-    HAL_UART_Receive_IT(dev->huart, &dev->rx_byte, 1);
+    for (uint32_t i = 0; i < UART_DEVICE_MAX_NUMS; i++) {
+        if (uart_devices[i] == NULL || uart_devices[i] == dev) {
+            uart_devices[i] = dev;
+            break;
+        }
+    }
+    // 启动接收
+    UART_StartReceive(dev);
 }
 
-// 以下函数请根据具体设备设置
+void UART_DeInitDev(UART_Device_t *dev) {
+    HAL_UART_Abort(dev->huart);
+    HAL_UART_DeInit(dev->huart);
+    for (uint32_t i = 0; i < UART_DEVICE_MAX_NUMS; i++) {
+        if (uart_devices[i] == dev) {
+            uart_devices[i] = NULL;
+        }
+    }
+}
+
+// HAL回调
+// 空闲线路、半满和全满时触发，size为DMA在缓冲区中的当前位置
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size) {
+    UART_Device_t *dev = UART_FindDev(huart);
+    if (dev == NULL) {
+        return;
+    }
+    uint16_t head = size & (UART_RX_BUFFER_SIZE - 1);
+    uint16_t tail = dev->rx_tail;
+    uint16_t old_head = dev->rx_head;
 
-// 自定义中断处理(未开启)
-void UART_userIRQ_Handler(UART_Device_t *dev) {}
+    // 新数据越过了未读取的位置，旧数据已被覆盖
+    if (((head - old_head) & (UART_RX_BUFFER_SIZE - 1)) >
+        ((tail - old_head - 1) & (UART_RX_BUFFER_SIZE - 1))) {
+        dev->rx_overflow++;
+    }
+    dev->rx_head = head;
+    if (dev->rx_callback == NULL) {
+        return;
+    }
+    // 回卷时分两段交给回调
+    if (head < old_head) {
+        UART_InvalidateDCache(&dev->rx_buffer[old_head],
+                              UART_RX_BUFFER_SIZE - old_head);
+        dev->rx_callback(&dev->rx_buffer[old_head],
+                         UART_RX_BUFFER_SIZE - old_head);
+        old_head = 0;
+    }
+    if (head > old_head) {
+        UART_InvalidateDCache(&dev->rx_buffer[old_head], head - old_head);
+        dev->rx_callback(&dev->rx_buffer[old_head], head - old_head);
+    }
+    dev->rx_tail = head;
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+    UART_Device_t *dev = UART_FindDev(huart);
+    if (dev == NULL) {
+        return;
+    }
+    dev->tx_busy = false;
+    dev->tx_tail++;
+    UART_StartTransmit(dev);
+}
+
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
+    UART_Device_t *dev = UART_FindDev(huart);
+    if (dev == NULL) {
+        return;
+    }
+    // 发送出错时丢弃当前帧，继续发送队列中的下一帧
+    if (dev->tx_busy && huart->gState == HAL_UART_STATE_READY) {
+        dev->tx_busy = false;
+        dev->tx_tail++;
+        UART_StartTransmit(dev);
+    }
+    // 接收被中止时（如溢出错误）重新启动循环接收
+    if (huart->RxState == HAL_UART_STATE_READY) {
+        UART_StartReceive(dev);
+    }
+    if (dev->error_callback != NULL) {
+        dev->error_callback();
+    }
+}
@@ -23,6 +23,7 @@
 
 /* USER CODE BEGIN INCLUDE */
 #include "boot.h"
+#include "boot_transport.h"
 /* USER CODE END INCLUDE */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -63,6 +64,8 @@
  */
 
 /* USER CODE BEGIN PRIVATE_DEFINES */
+// 排队发送的帧数，与boot发送缓冲池的缓冲个数一致，池不空时队列不会满
+#define CDC_TX_QUEUE_SIZE (BOOT_TX_SMALL_NUMS + BOOT_TX_LARGE_NUMS)
 /* USER CODE END PRIVATE_DEFINES */
 
 /**
@@ -95,7 +98,13 @@ uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
 uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
 
 /* USER CODE BEGIN PRIVATE_VARIABLES */
-
+// 排队等待发送的boot发送池缓冲，发送完成后在CDC_TransmitCplt_FS中释放
+static struct {
+    uint8_t *buf;
+    uint16_t len;
+} cdc_tx_queue[CDC_TX_QUEUE_SIZE];
+static volatile uint8_t cdc_tx_head = 0;
+static volatile uint8_t cdc_tx_count = 0;
 /* USER CODE END PRIVATE_VARIABLES */
 
 // 线路编码结构体
@@ -117,6 +126,7 @@ USBD_CDC_LineCodingTypeDef LineCoding = {
 extern USBD_HandleTypeDef hUsbDeviceFS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
+extern BootTransport_t BootCDC;
 
 /* USER CODE END EXPORTED_VARIABLES */
 
@@ -169,6 +179,12 @@ static int8_t CDC_Init_FS(void) {
  */
 static int8_t CDC_DeInit_FS(void) {
     /* USER CODE BEGIN 4 */
+    // 断开或复位后不会再有发送完成，释放排队的缓冲
+    while (cdc_tx_count > 0) {
+        Boot_TxBufRelease(cdc_tx_queue[cdc_tx_head].buf);
+        cdc_tx_head = (cdc_tx_head + 1) % CDC_TX_QUEUE_SIZE;
+        cdc_tx_count--;
+    }
     return (USBD_OK);
     /* USER CODE END 4 */
 }
@@ -279,10 +295,8 @@ static int8_t CDC_Receive_FS(uint8_t *Buf, uint32_t *Len) {
     USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
     USBD_CDC_ReceivePacket(&hUsbDeviceFS);
 
-    // 按字节接收
-    for (uint32_t i = 0; i < *Len; i++) {
-        Boot_ReceiveCommand(Buf[i]);
-    }
+    // 送入USB CDC通道的解析器
+    Boot_TransportReceive(&BootCDC, Buf, (uint16_t)*Len);
     return (USBD_OK);
     /* USER CODE END 6 */
 }
@@ -303,6 +317,10 @@ uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len) {
     /* USER CODE BEGIN 7 */
     USBD_CDC_HandleTypeDef *hcdc =
         (USBD_CDC_HandleTypeDef *)hUsbDeviceFS.pClassData;
+    // USB未枚举时类数据为空，跳转app前的状态上报可能走到这里
+    if (hcdc == NULL) {
+        return USBD_FAIL;
+    }
     if (hcdc->TxState != 0) {
         return USBD_BUSY;
     }
@@ -328,14 +346,70 @@ uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len) {
 static int8_t CDC_TransmitCplt_FS(uint8_t *Buf, uint32_t *Len, uint8_t epnum) {
     uint8_t result = USBD_OK;
     /* USER CODE BEGIN 13 */
-    UNUSED(Buf);
     UNUSED(Len);
     UNUSED(epnum);
+    // 队首帧发送完成，释放缓冲并发出下一帧；
+    // 直接用CDC_Transmit_FS发送的数据不在队列中
+    if (cdc_tx_count > 0 && cdc_tx_queue[cdc_tx_head].buf == Buf) {
+        Boot_TxBufRelease(Buf);
+        cdc_tx_head = (cdc_tx_head + 1) % CDC_TX_QUEUE_SIZE;
+        cdc_tx_count--;
+    }
+    if (cdc_tx_count > 0) {
+        USBD_CDC_SetTxBuffer(&hUsbDeviceFS, cdc_tx_queue[cdc_tx_head].buf,
+                             cdc_tx_queue[cdc_tx_head].len);
+        USBD_CDC_TransmitPacket(&hUsbDeviceFS);
+    }
+    Boot_TransportTxDone(&BootCDC);
     /* USER CODE END 13 */
     return result;
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+/**
+ * @brief  CDC_TransmitQueued_FS
+ *         Queue a boot TX pool buffer, sent back to back without waiting.
+ *         The buffer is released in CDC_TransmitCplt_FS.
+ * @param  Buf: Buffer from Boot_TxBufAlloc
+ * @param  Len: Number of data to be sent (in bytes)
+ * @retval USBD_OK if queued, USBD_BUSY if the queue is full,
+ *         USBD_FAIL if not enumerated
+ */
+uint8_t CDC_TransmitQueued_FS(uint8_t *Buf, uint16_t Len) {
+    USBD_CDC_HandleTypeDef *hcdc =
+        (USBD_CDC_HandleTypeDef *)hUsbDeviceFS.pClassData;
+    if (hcdc == NULL) {
+        return USBD_FAIL;
+    }
+    // 与USB中断中的发送完成互斥
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (cdc_tx_count >= CDC_TX_QUEUE_SIZE) {
+        __set_PRIMASK(primask);
+        return USBD_BUSY;
+    }
+    uint8_t tail = (cdc_tx_head + cdc_tx_count) % CDC_TX_QUEUE_SIZE;
+    cdc_tx_queue[tail].buf = Buf;
+    cdc_tx_queue[tail].len = Len;
+    cdc_tx_count++;
+    // 端点空闲时立即发出，否则由上一帧的发送完成接着发
+    if (cdc_tx_count == 1 && hcdc->TxState == 0) {
+        USBD_CDC_SetTxBuffer(&hUsbDeviceFS, Buf, Len);
+        USBD_CDC_TransmitPacket(&hUsbDeviceFS);
+    }
+    __set_PRIMASK(primask);
+    return USBD_OK;
+}
+
+/**
+ * @brief  CDC_IsTxIdle_FS
+ * @retval true when the queue is empty and the IN endpoint is idle
+ */
+bool CDC_IsTxIdle_FS(void) {
+    USBD_CDC_HandleTypeDef *hcdc =
+        (USBD_CDC_HandleTypeDef *)hUsbDeviceFS.pClassData;
+    return hcdc == NULL || (cdc_tx_count == 0 && hcdc->TxState == 0);
+}
 
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
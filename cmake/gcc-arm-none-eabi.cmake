@@ -14,6 +14,10 @@ set(CMAKE_CXX_COMPILER              ${TOOLCHAIN_PREFIX}g++)
 set(CMAKE_LINKER                    ${TOOLCHAIN_PREFIX}g++)
 set(CMAKE_OBJCOPY                   ${TOOLCHAIN_PREFIX}objcopy)
 set(CMAKE_SIZE                      ${TOOLCHAIN_PREFIX}size)
+set(CMAKE_NM                        ${TOOLCHAIN_PREFIX}nm)
+# 静态库中的LTO目标文件需要带插件的ar建立符号表
+set(CMAKE_AR                        ${TOOLCHAIN_PREFIX}gcc-ar)
+set(CMAKE_RANLIB                    ${TOOLCHAIN_PREFIX}gcc-ranlib)
 
 set(CMAKE_EXECUTABLE_SUFFIX_ASM     ".elf")
 set(CMAKE_EXECUTABLE_SUFFIX_C       ".elf")
@@ -30,6 +34,10 @@ set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -Wall -fdata-sections -ffunction-sections")
 
 set(CMAKE_C_FLAGS_DEBUG "-O0 -g3")
 set(CMAKE_C_FLAGS_RELEASE "-Os -g0")
+# 最小体积：LTO跨文件内联并删除未用代码；-ffat-lto-objects保留普通目标代码，
+# 编译时照常生成.su/.ci供栈深检查
+set(CMAKE_C_FLAGS_MINSIZEREL "-Os -g0 -flto -ffat-lto-objects")
+set(CMAKE_EXE_LINKER_FLAGS_MINSIZEREL "-Os -flto")
 set(CMAKE_CXX_FLAGS_DEBUG "-O0 -g3")
 set(CMAKE_CXX_FLAGS_RELEASE "-Os -g0")
 
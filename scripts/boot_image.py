@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""填写固件头：长度、版本和CRC32。
+
+固件头位于镜像偏移0x298（紧跟中断向量表），格式见
+Components/TinyEmbedBoot/boot_image.h：
+
+    uint32_t magic;   // "TEBI"
+    uint32_t version;
+    uint32_t length;  // 镜像总长度
+    uint32_t crc32;   // 整个镜像的CRC32，跳过本字段
+
+CRC算法与片上CRC单元默认配置一致（CRC-32/MPEG-2）：
+多项式0x04C11DB7，初值0xFFFFFFFF，不反转，无结果异或。
+
+没有固件头的镜像（例如bootloader本身）原样跳过。
+给出--elf时同时用objcopy更新ELF中的.image_header段，
+这样之后由ELF生成的hex与bin一致。
+"""
+import argparse
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+IMAGE_MAGIC = 0x49424554
+HEADER_FORMAT = "<IIII"
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+CRC_FIELD_OFFSET = 12
+
+
+def _make_table():
+    table = []
+    for i in range(256):
+        crc = i << 24
+        for _ in range(8):
+            if crc & 0x80000000:
+                crc = ((crc << 1) ^ 0x04C11DB7) & 0xFFFFFFFF
+            else:
+                crc = (crc << 1) & 0xFFFFFFFF
+        table.append(crc)
+    return table
+
+
+_TABLE = _make_table()
+
+
+def crc32_mpeg2(data, crc=0xFFFFFFFF):
+    for b in data:
+        crc = ((crc << 8) & 0xFFFFFFFF) ^ _TABLE[((crc >> 24) ^ b) & 0xFF]
+    return crc
+
+
+def image_crc(image, offset):
+    crc_pos = offset + CRC_FIELD_OFFSET
+    crc = crc32_mpeg2(image[:crc_pos])
+    return crc32_mpeg2(image[crc_pos + 4:], crc)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bin", required=True, help="objcopy生成的bin文件")
+    parser.add_argument("--version", type=lambda x: int(x, 0), default=0,
+                        help="固件版本号")
+    parser.add_argument("--offset", type=lambda x: int(x, 0), default=0x298,
+                        help="固件头在镜像内的偏移")
+    parser.add_argument("--elf", help="同步更新的ELF文件")
+    parser.add_argument("--objcopy", default="arm-none-eabi-objcopy")
+    args = parser.parse_args()
+
+    with open(args.bin, "rb") as f:
+        image = bytearray(f.read())
+
+    if len(image) < args.offset + HEADER_SIZE:
+        print("boot_image: %s has no image header, skipped" % args.bin)
+        return 0
+    magic, = struct.unpack_from("<I", image, args.offset)
+    if magic != IMAGE_MAGIC:
+        print("boot_image: %s has no image header, skipped" % args.bin)
+        return 0
+
+    struct.pack_into(HEADER_FORMAT, image, args.offset,
+                     IMAGE_MAGIC, args.version, len(image), 0)
+    crc = image_crc(image, args.offset)
+    struct.pack_into("<I", image, args.offset + CRC_FIELD_OFFSET, crc)
+    header = bytes(image[args.offset:args.offset + HEADER_SIZE])
+
+    with open(args.bin, "wb") as f:
+        f.write(image)
+
+    if args.elf:
+        fd, header_path = tempfile.mkstemp(suffix=".bin")
+        try:
+            with os.fdopen(fd, "wb") as f:
+                f.write(header)
+            subprocess.check_call([args.objcopy, "--update-section",
+                                   ".image_header=" + header_path, args.elf])
+        finally:
+            os.remove(header_path)
+
+    print("boot_image: version 0x%08X, length %d, crc32 0x%08X"
+          % (args.version, len(image), crc))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,455 @@
+#!/usr/bin/env python3
+"""检查最坏栈深和各组件的flash/RAM占用，超出预算时返回非0。
+
+CMake选项BOOT_BUDGET_CHECK打开时作为构建后步骤运行，超出预算则构建失败；
+默认关闭，memory_report目标带--no-check只生成报告。
+
+编译时加-fstack-usage -fcallgraph-info=su，GCC为每个源文件在目标文件旁生成
+.su（每个函数的栈帧）和.ci（带栈帧的调用图）。本脚本：
+
+1. 读取构建目录下所有.ci建立调用图，用预算文件[indirect]补充函数指针调用，
+   计算main和每个中断处理函数的最坏栈深；
+2. 中断按[stack]中的抢占优先级分组叠加，每嵌套一级再加一个异常栈帧，
+   得到主栈的最坏总深度，与预算比较（默认取链接脚本的_Min_Stack_Size）；
+   fault中列出的故障异常不会返回，只单独报告，不参与叠加；
+3. 解析链接map，按目标文件路径把输入段归到组件，统计flash和RAM，
+   与各组件的预算比较；LTO构建的代码来自ltrans临时文件，用nm按符号查回原文件；
+4. 报告bootloader镜像在flash中的大小和到BOOT_APP_ADDRESS的余量，重叠时失败。
+
+调用图中没有栈信息的外部函数（libc等）用[external]中的估计值，
+没有估计值的和未补充的函数指针调用只在报告中列出，不计入栈深。
+"""
+import argparse
+import configparser
+import os
+import re
+import subprocess
+import sys
+
+# Cortex-M7开启FPU时的扩展异常栈帧：8个整数寄存器+18个浮点字
+EXCEPTION_FRAME_SIZE = 104
+# 向量表按1KB对齐才能写入VTOR（H750的向量表超过512字节）
+VECTOR_TABLE_ALIGN = 0x400
+
+HANDLER_PATTERN = re.compile(r"^[A-Za-z0-9_]+_(IRQ)?Handler$")
+CI_NODE = re.compile(r'^node: \{ title: "([^"]+)" label: "([^"]*)"')
+CI_EDGE = re.compile(r'^edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+CI_STACK = re.compile(r"\\n(\d+) bytes \((static|dynamic|bounded)[^)]*\)")
+
+
+def parse_int(text):
+    return int(text.strip(), 0)
+
+
+class CallGraph:
+    def __init__(self):
+        self.stack = {}  # 标题 -> 栈帧字节数
+        self.qualifier = {}  # 标题 -> static/dynamic/bounded
+        self.edges = {}  # 标题 -> 被调标题集合
+        self.names = {}  # 函数名 -> 标题集合（static函数标题带文件名）
+        self.indirect = set()  # 有函数指针调用的函数
+
+    def load(self, path):
+        with open(path, encoding="utf-8", errors="replace") as f:
+            for line in f:
+                node = CI_NODE.match(line)
+                if node:
+                    title, label = node.groups()
+                    name = label.split("\\n", 1)[0]
+                    if title == "__indirect_call":
+                        continue
+                    self.names.setdefault(name, set()).add(title)
+                    stack = CI_STACK.search(label)
+                    if stack:
+                        self.stack[title] = int(stack.group(1))
+                        self.qualifier[title] = stack.group(2)
+                    continue
+                edge = CI_EDGE.match(line)
+                if edge:
+                    source, target = edge.groups()
+                    if target == "__indirect_call":
+                        self.indirect.add(source)
+                    else:
+                        self.edges.setdefault(source, set()).add(target)
+
+    def resolve(self, name):
+        return self.names.get(name, set())
+
+    def add_indirect(self, caller, callees):
+        for source in self.resolve(caller):
+            self.indirect.discard(source)
+            for callee in callees:
+                self.edges.setdefault(source, set()).update(
+                    self.resolve(callee) or {callee})
+
+    def depth(self, root, external, notes):
+        """最坏栈深，返回(字节数, 调用路径)"""
+        memo = {}
+        active = set()
+
+        def visit(title):
+            if title in memo:
+                return memo[title]
+            if title in active:
+                notes.add("recursion through %s, not bounded" % title)
+                return 0, []
+            active.add(title)
+            if title in self.stack:
+                own = self.stack[title]
+                if self.qualifier[title] != "static":
+                    notes.add("%s has a %s frame" %
+                              (title, self.qualifier[title]))
+            elif title in external:
+                own = external[title]
+            else:
+                own = 0
+                notes.add("no stack info for %s" % title)
+            if title in self.indirect:
+                notes.add("unresolved indirect call in %s" % title)
+            best, best_path = 0, []
+            for callee in sorted(self.edges.get(title, ())):
+                size, path = visit(callee)
+                if size > best:
+                    best, best_path = size, path
+            active.discard(title)
+            memo[title] = (own + best, [(title, own)] + best_path)
+            return memo[title]
+
+        return visit(root)
+
+
+def load_callgraph(build_dir):
+    graph = CallGraph()
+    count = 0
+    for dirpath, _, files in os.walk(build_dir):
+        for name in files:
+            if name.endswith(".ci"):
+                graph.load(os.path.join(dirpath, name))
+                count += 1
+    return graph, count
+
+
+def linker_stack_size(path):
+    with open(path, encoding="utf-8", errors="replace") as f:
+        match = re.search(r"_Min_Stack_Size\s*=\s*(0x[0-9A-Fa-f]+|\d+)",
+                          f.read())
+    return parse_int(match.group(1)) if match else None
+
+
+def stack_report(graph, budget, ld_path, lines):
+    external = {name: parse_int(value)
+                for name, value in budget.items("external")} \
+        if budget.has_section("external") else {}
+    if budget.has_section("indirect"):
+        for caller, callees in budget.items("indirect"):
+            graph.add_indirect(caller, callees.split())
+
+    notes = set()
+    main_size, main_path = graph.depth("main", external, notes)
+
+    # 中断按优先级分组，同组不会互相嵌套，未列出的中断各自算一级
+    levels = []
+    faults = []
+    listed = set()
+    if budget.has_section("stack"):
+        for key, value in sorted(budget.items("stack")):
+            if key.startswith("level"):
+                names = value.split()
+                levels.append(names)
+                listed.update(names)
+        if budget.has_option("stack", "fault"):
+            faults = budget.get("stack", "fault").split()
+            listed.update(faults)
+    handlers = sorted(title for title in graph.stack
+                      if HANDLER_PATTERN.match(title))
+    levels += [[name] for name in handlers if name not in listed]
+
+    lines.append("Stack (worst case per root, bytes)")
+    lines.append("  %-32s %6d  %s" % ("main", main_size,
+                                       " > ".join(t for t, _ in main_path)))
+    total = main_size
+    for names in levels:
+        worst, worst_name = 0, None
+        for name in names:
+            for title in graph.resolve(name):
+                size, path = graph.depth(title, external, notes)
+                lines.append("  %-32s %6d  %s" % (
+                    title, size, " > ".join(t for t, _ in path)))
+                if size > worst:
+                    worst, worst_name = size, title
+        if worst_name is not None:
+            total += worst + EXCEPTION_FRAME_SIZE
+    lines.append("  %-32s %6d  (main + deepest handler per priority level"
+                 " + %d-byte exception frames)" % ("total", total,
+                                                   EXCEPTION_FRAME_SIZE))
+    # 故障异常进入后不返回，不叠加到总深度
+    for name in faults:
+        for title in graph.resolve(name):
+            size, path = graph.depth(title, external, notes)
+            lines.append("  %-32s %6d  (fault, not stacked) %s" % (
+                title, size, " > ".join(t for t, _ in path)))
+    for note in sorted(notes):
+        lines.append("  note: " + note)
+
+    limit = None
+    if budget.has_option("stack", "limit"):
+        limit = parse_int(budget.get("stack", "limit"))
+    elif ld_path:
+        limit = linker_stack_size(ld_path)
+    if limit is not None and total > limit:
+        return ["stack: worst case %d bytes exceeds budget %d" % (total, limit)]
+    return []
+
+
+MAP_REGION = re.compile(
+    r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(\s+\S+)?\s*$")
+MAP_OUTPUT = re.compile(
+    r"^(\.\S+|\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)"
+    r"(?:\s+load address 0x([0-9a-fA-F]+))?\s*$")
+# 不加载到目标内存的调试和属性段，地址从0开始会误落到ITCMRAM
+MAP_NOLOAD = re.compile(r"^\.(debug|comment|stab|ARM\.attributes)")
+MAP_INPUT = re.compile(
+    r"^ (\S+)?\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+
+
+def parse_map(path):
+    """返回(内存区域列表, [(输出段, 地址, 大小, 目标文件, 输入段名)])"""
+    regions = []
+    sections = []
+    with open(path, encoding="utf-8", errors="replace") as f:
+        lines = f.read().splitlines()
+
+    i = 0
+    while i < len(lines) and not lines[i].startswith("Memory Configuration"):
+        i += 1
+    i += 1
+    while i < len(lines) and not lines[i].startswith("Linker script and memory"):
+        match = MAP_REGION.match(lines[i])
+        if match and match.group(1) not in ("Name", "*default*"):
+            regions.append((match.group(1), int(match.group(2), 16),
+                            int(match.group(3), 16)))
+        i += 1
+
+    output = None
+    pending = None  # 名字太长时地址和大小换到下一行
+    for line in lines[i:]:
+        if not line.strip():
+            continue
+        if not line.startswith(" "):
+            match = MAP_OUTPUT.match(line)
+            if match and match.group(1):
+                address = int(match.group(2), 16)
+                load = int(match.group(4), 16) if match.group(4) else address
+                output = (match.group(1), address, load)
+                pending = None
+            elif re.match(r"^\.\S+$", line):
+                output = None
+                pending = ("output", line.strip())
+            else:
+                output = None
+            continue
+        if pending and pending[0] == "output":
+            match = MAP_OUTPUT.match(pending[1] + line)
+            if match:
+                address = int(match.group(2), 16)
+                load = int(match.group(4), 16) if match.group(4) else address
+                output = (match.group(1), address, load)
+            pending = None
+            continue
+        if output is None or MAP_NOLOAD.match(output[0]):
+            continue
+        if line.startswith(" *fill*"):
+            match = re.match(r"^ \*fill\*\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)",
+                             line)
+            if match:
+                sections.append((output, int(match.group(1), 16),
+                                 int(match.group(2), 16), "*fill*", "*fill*"))
+            continue
+        match = MAP_INPUT.match(line)
+        if match and match.group(1):
+            pending = None
+            sections.append((output, int(match.group(2), 16),
+                             int(match.group(3), 16), match.group(4).strip(),
+                             match.group(1)))
+        elif match and pending and pending[0] == "input":
+            sections.append((output, int(match.group(2), 16),
+                             int(match.group(3), 16), match.group(4).strip(),
+                             pending[1]))
+            pending = None
+        elif re.match(r"^ \.\S+$", line) or re.match(r"^ COMMON$", line):
+            pending = ("input", line.strip())
+        else:
+            pending = None
+    return regions, sections
+
+
+def region_of(regions, address):
+    for name, origin, length in regions:
+        if origin <= address < origin + length:
+            return name
+    return None
+
+
+def symbol_index(build_dir, nm):
+    """LTO后map中的代码都来自ltrans临时文件，用nm从原目标文件查回符号所属文件"""
+    objects = []
+    for dirpath, _, files in os.walk(build_dir):
+        objects += [os.path.join(dirpath, name) for name in files
+                    if name.endswith((".obj", ".o"))]
+    index = {}
+    if not nm or not objects:
+        return index
+    try:
+        output = subprocess.run([nm, "--defined-only", "-A"] + objects,
+                                capture_output=True, text=True).stdout
+    except OSError:
+        return index
+    for line in output.splitlines():
+        # 路径:地址 类型 符号名
+        path, _, rest = line.rpartition(":")
+        fields = rest.split()
+        if path and len(fields) == 3:
+            index.setdefault(fields[2], path)
+    return index
+
+
+def lto_owner(section, index):
+    """.text.Boot_Init.lto_priv.0 -> Boot_Init所在的目标文件"""
+    parts = section.split(".")
+    if len(parts) < 3:
+        return None
+    return index.get(parts[2])
+
+
+def component_report(regions, sections, budget, index, lines):
+    components = [(name, budget.get(name, "match").split())
+                  for name in budget.sections()
+                  if budget.has_option(name, "match")]
+    flash_regions = budget.get("memory", "flash", fallback="FLASH").split()
+
+    usage = {}
+    for (output, out_address, out_load), address, size, obj, section \
+            in sections:
+        if size == 0:
+            continue
+        region = region_of(regions, address)
+        if region is None:
+            continue  # 不占用内存的调试段等
+        load_region = region_of(regions, out_load + (address - out_address))
+        owner = "other"
+        if ".ltrans" in obj:
+            obj = lto_owner(section, index) or obj
+        normalized = obj.replace("\\", "/")
+        for name, patterns in components:
+            if any(pattern in normalized for pattern in patterns):
+                owner = name
+                break
+        entry = usage.setdefault(owner, {"flash": 0, "ram": 0})
+        if region in flash_regions:
+            entry["flash"] += size
+        else:
+            entry["ram"] += size
+            # .data等有初值的段在flash中还有一份
+            if load_region in flash_regions:
+                entry["flash"] += size
+
+    lines.append("")
+    lines.append("Memory by component (bytes)")
+    lines.append("  %-16s %8s %8s %8s %8s" %
+                 ("component", "flash", "budget", "ram", "budget"))
+    errors = []
+    names = [name for name, _ in components] + ["other"]
+    for name in names:
+        entry = usage.get(name, {"flash": 0, "ram": 0})
+        row = [name, entry["flash"], "-", entry["ram"], "-"]
+        for index, kind in ((2, "flash"), (4, "ram")):
+            if budget.has_option(name, kind):
+                limit = parse_int(budget.get(name, kind))
+                row[index] = limit
+                if entry[kind] > limit:
+                    errors.append("%s: %s %d bytes exceeds budget %d" %
+                                  (name, kind, entry[kind], limit))
+        lines.append("  %-16s %8d %8s %8d %8s" % tuple(row))
+    return errors
+
+
+def footprint_report(regions, sections, budget, cfg_path, lines):
+    """bootloader镜像在flash中的结束地址和到app加载地址的余量"""
+    flash_regions = budget.get("memory", "flash", fallback="FLASH").split()
+    start, end = None, None
+    for (output, out_address, out_load), address, size, _, _ in sections:
+        load = out_load + (address - out_address)
+        if size == 0 or region_of(regions, load) not in flash_regions:
+            continue
+        start = load if start is None else min(start, load)
+        end = load + size if end is None else max(end, load + size)
+    if start is None:
+        return []
+
+    lines.append("")
+    lines.append("Flash image: %d bytes (0x%08x-0x%08x)" %
+                 (end - start, start, end))
+    app_address = None
+    if cfg_path:
+        with open(cfg_path, encoding="utf-8", errors="replace") as f:
+            match = re.search(r"#define\s+BOOT_APP_ADDRESS\s+\(?\s*"
+                              r"(0x[0-9A-Fa-f]+|\d+)", f.read())
+        if match:
+            app_address = parse_int(match.group(1))
+    if app_address is None:
+        return []
+    lowest = (end + VECTOR_TABLE_ALIGN - 1) & ~(VECTOR_TABLE_ALIGN - 1)
+    lines.append("  BOOT_APP_ADDRESS 0x%08x, headroom %d bytes, "
+                 "lowest aligned app address 0x%08x" %
+                 (app_address, app_address - end, lowest))
+    if end > app_address:
+        return ["flash: image ends at 0x%08x, past BOOT_APP_ADDRESS 0x%08x" %
+                (end, app_address)]
+    return []
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--map", required=True, help="linker map file")
+    parser.add_argument("--build-dir", required=True,
+                        help="directory searched for .ci call graph files")
+    parser.add_argument("--budget", required=True, help="budget ini file")
+    parser.add_argument("--ld", help="linker script, for _Min_Stack_Size")
+    parser.add_argument("--cfg", help="boot_cfg.h, for BOOT_APP_ADDRESS")
+    parser.add_argument("--nm", help="nm used to attribute LTO sections")
+    parser.add_argument("--output", help="also write the report to this file")
+    parser.add_argument("--no-check", action="store_true",
+                        help="only print the report, never fail")
+    args = parser.parse_args()
+
+    budget = configparser.ConfigParser(inline_comment_prefixes=("#", ";"))
+    budget.optionxform = str  # 函数名区分大小写
+    budget.read(args.budget, encoding="utf-8")
+
+    lines = []
+    errors = []
+    graph, count = load_callgraph(args.build_dir)
+    if count == 0:
+        errors.append("no .ci files under %s, build with "
+                      "-fcallgraph-info=su" % args.build_dir)
+    else:
+        errors += stack_report(graph, budget, args.ld, lines)
+    regions, sections = parse_map(args.map)
+    index = {}
+    if any(".ltrans" in entry[3] for entry in sections):
+        index = symbol_index(args.build_dir, args.nm)
+    errors += component_report(regions, sections, budget, index, lines)
+    errors += footprint_report(regions, sections, budget, args.cfg, lines)
+
+    report = "\n".join(lines) + "\n"
+    sys.stdout.write(report)
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            f.write(report)
+    for error in errors:
+        sys.stderr.write("budget exceeded: %s\n" % error)
+    return 1 if errors and not args.no_check else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
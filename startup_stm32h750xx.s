@@ -43,6 +43,12 @@ defined in linker script */
 .word  _sbss
 /* end address for the .bss section. defined in linker script */
 .word  _ebss
+/* start address for the initialization values of the ITCM code. defined in linker script */
+.word  _siitcm
+/* start address for the ITCM code. defined in linker script */
+.word  _sitcm
+/* end address for the ITCM code. defined in linker script */
+.word  _eitcm
 /* stack used for SystemInit_ExtMemCtl; always internal RAM used */
 
 /**
@@ -81,6 +87,25 @@ LoopCopyDataInit:
   adds r4, r0, r3
   cmp r4, r1
   bcc CopyDataInit
+
+/* Copy the hot code from flash to ITCMRAM */
+  ldr r0, =_sitcm
+  ldr r1, =_eitcm
+  ldr r2, =_siitcm
+  movs r3, #0
+  b LoopCopyItcmInit
+
+CopyItcmInit:
+  ldr r4, [r2, r3]
+  str r4, [r0, r3]
+  adds r3, r3, #4
+
+LoopCopyItcmInit:
+  adds r4, r0, r3
+  cmp r4, r1
+  bcc CopyItcmInit
+  dsb
+  isb
 /* Zero fill the bss segment. */
   ldr r2, =_sbss
   ldr r4, =_ebss
@@ -1,4 +1,9 @@
 #include "boot_cmd.h"
+#include "boot_combine.h"
+#include "boot_event.h"
+#include "boot_resume.h"
+#include "boot_slot_meta.h"
+#include "boot_task.h"
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
@@ -12,6 +17,16 @@ void test_parse_invalid_length(void);
 void test_parse_invalid_checksum(void);
 void test_parse_incomplete_frame(void);
 void test_build_and_parse_roundtrip(void);
+void test_parser_instances(void);
+void test_frame_check(void);
+void test_parse_resync(void);
+void test_event_queue(void);
+void test_task_scheduler(void);
+void test_tx_pool(void);
+void test_upload_resume(void);
+void test_slot_updates(void);
+void test_write_combine(void);
+void test_block_crc_pending(void);
 
 // 辅助函数：打印帧内容
 void print_frame(const command_frame_t *frame, const char *label) {
@@ -59,6 +74,16 @@ int main() {
     test_parse_invalid_checksum();
     test_parse_incomplete_frame();
     test_build_and_parse_roundtrip();
+    test_parser_instances();
+    test_frame_check();
+    test_parse_resync();
+    test_event_queue();
+    test_task_scheduler();
+    test_tx_pool();
+    test_upload_resume();
+    test_slot_updates();
+    test_write_combine();
+    test_block_crc_pending();
 
     printf("All tests passed!\n");
     return 0;
@@ -257,7 +282,9 @@ void test_build_and_parse_roundtrip(void) {
     // 测试多个命令类型
     command_type_t test_commands[] = {CMD_ENTER_BOOT,    CMD_UPLOAD, CMD_VERIFY,
                                       CMD_RUN_APP,       CMD_ACK,    CMD_NACK,
-                                      CMD_ERROR_RESPONSE};
+                                      CMD_ERROR_RESPONSE, CMD_ABORT,
+                                      CMD_STATUS, CMD_UPLOAD_RECORD,
+                                      CMD_BLOCK_CRC};
 
     // 测试不同长度的数据
     uint8_t test_data_sets[][10] = {
@@ -313,4 +340,598 @@ void test_build_and_parse_roundtrip(void) {
     }
 
     printf("Roundtrip test passed!\n\n");
-}
\ No newline at end of file
+}
+// 测试多个解析器实例交错接收互不干扰，以及实例的最大数据长度
+void test_parser_instances(void) {
+    printf("=== Test: Parser Instances ===\n");
+
+    // 两个实例各用自己的帧缓冲，b的缓冲只够4字节数据
+    static uint8_t buffer_a[COMMAND_PARSER_BUFFER_SIZE(FRAME_DATA_SIZE)];
+    static uint8_t buffer_b[COMMAND_PARSER_BUFFER_SIZE(4)];
+    command_parser_t parser_a;
+    command_parser_t parser_b;
+    command_parser_setup(&parser_a, buffer_a, sizeof(buffer_a));
+    command_parser_setup(&parser_b, buffer_b, sizeof(buffer_b));
+
+    uint8_t data_a[] = {0x11, 0x22, 0x33};
+    uint8_t data_b[] = {0xAA, 0xBB};
+    uint8_t frame_a[FRAME_SIZE];
+    uint8_t frame_b[FRAME_SIZE];
+    uint16_t len_a = command_build_frame(CMD_UPLOAD, data_a, sizeof(data_a), frame_a);
+    uint16_t len_b = command_build_frame(CMD_VERIFY, data_b, sizeof(data_b), frame_b);
+
+    // 逐字节交错送入两个实例
+    parse_result_t result_a = PARSE_INCOMPLETE;
+    parse_result_t result_b = PARSE_INCOMPLETE;
+    for (uint16_t i = 0; i < len_a || i < len_b; i++) {
+        if (i < len_a) {
+            result_a = command_parser_process_byte(&parser_a, frame_a[i]);
+        }
+        if (i < len_b) {
+            result_b = command_parser_process_byte(&parser_b, frame_b[i]);
+        }
+    }
+    assert(result_a == PARSE_SUCCESS);
+    assert(result_b == PARSE_SUCCESS);
+
+    command_frame_t parsed;
+    assert(command_parser_get_frame(&parser_a, &parsed));
+    assert(parsed.command == CMD_UPLOAD);
+    assert(memcmp(parsed.data, data_a, sizeof(data_a)) == 0);
+    assert(command_parser_get_frame(&parser_b, &parsed));
+    assert(parsed.command == CMD_VERIFY);
+    assert(memcmp(parsed.data, data_b, sizeof(data_b)) == 0);
+
+    // 超过实例最大数据长度的帧被拒绝
+    uint16_t len = command_build_frame(CMD_UPLOAD, data_a, sizeof(data_a), frame_a);
+    command_parser_limit(&parser_b, 2);
+    parse_result_t result = PARSE_INCOMPLETE;
+    for (uint16_t i = 0; i < len && result == PARSE_INCOMPLETE; i++) {
+        result = command_parser_process_byte(&parser_b, frame_a[i]);
+    }
+    assert(result == PARSE_ERROR_LENGTH);
+    assert(command_parser_get_state(&parser_b) == RX_STATE_HEADER1);
+
+    printf("Parser instances test passed!\n\n");
+}
+
+// 测试帧校验方式：标准测试向量、按字累加的和校验、CRC帧往返
+void test_frame_check(void) {
+    printf("=== Test: Frame Check ===\n");
+
+    const uint8_t vector[] = "123456789";
+    assert(command_calc_check(FRAME_CHECK_CRC16, vector, 9) == 0x29B1);
+    assert(command_calc_check(FRAME_CHECK_CRC32, vector, 9) == 0x0376E6E7);
+
+    // 不同起始偏移和长度下与逐字节累加结果一致
+    static uint8_t data[600];
+    for (uint16_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i * 131 + 7);
+    }
+    for (uint8_t offset = 0; offset < 4; offset++) {
+        for (uint16_t len = 0; len + offset <= sizeof(data); len += 13) {
+            uint8_t sum = 0;
+            for (uint16_t i = 0; i < len; i++) {
+                sum += data[offset + i];
+            }
+            assert(command_calc_check(FRAME_CHECK_SUM8, data + offset, len) ==
+                   (uint8_t)~sum);
+        }
+    }
+
+    static uint8_t buffer[COMMAND_PARSER_BUFFER_SIZE(FRAME_DATA_SIZE)];
+    command_parser_t parser;
+    command_parser_setup(&parser, buffer, sizeof(buffer));
+    frame_check_t modes[] = {FRAME_CHECK_CRC16, FRAME_CHECK_CRC32};
+    for (uint8_t m = 0; m < 2; m++) {
+        command_parser_set_check(&parser, modes[m]);
+        uint8_t output_buffer[FRAME_SIZE];
+        uint16_t len = command_build_frame_ex(CMD_UPLOAD, data, 300, modes[m],
+                                              output_buffer);
+        assert(len == 5 + 300 + command_check_size(modes[m]));
+
+        // 交换两个数据字节，8位和校验发现不了，CRC可以
+        uint8_t swapped[FRAME_SIZE];
+        memcpy(swapped, output_buffer, len);
+        swapped[10] = output_buffer[11];
+        swapped[11] = output_buffer[10];
+        parse_result_t result = PARSE_INCOMPLETE;
+        for (uint16_t i = 0; i < len; i++) {
+            result = command_parser_process_byte(&parser, swapped[i]);
+        }
+        assert(result == PARSE_ERROR_CHECKSUM);
+
+        for (uint16_t i = 0; i < len; i++) {
+            result = command_parser_process_byte(&parser, output_buffer[i]);
+        }
+        assert(result == PARSE_SUCCESS);
+        command_frame_t parsed;
+        assert(command_parser_get_frame(&parser, &parsed));
+        assert(parsed.data_length == 300);
+        assert(memcmp(parsed.data, data, 300) == 0);
+
+        // CMD_ENTER_BOOT始终使用8位和校验
+        len = command_build_frame(CMD_ENTER_BOOT, data, 1, output_buffer);
+        for (uint16_t i = 0; i < len; i++) {
+            result = command_parser_process_byte(&parser, output_buffer[i]);
+        }
+        assert(result == PARSE_SUCCESS);
+    }
+
+    printf("Frame check test passed!\n\n");
+}
+
+// 测试出错后重新同步：重复的帧头、长度出错吞掉后面的帧、校验错误后紧跟的帧
+void test_parse_resync(void) {
+    printf("=== Test: Parse Resync ===\n");
+
+    static uint8_t buffer[COMMAND_PARSER_BUFFER_SIZE(64)];
+    command_parser_t parser;
+    command_parser_setup(&parser, buffer, sizeof(buffer));
+
+    uint8_t data[] = {0x11, 0x22, 0x33, 0x44};
+    uint8_t frame[FRAME_SIZE];
+    uint16_t len = command_build_frame(CMD_UPLOAD, data, sizeof(data), frame);
+    command_frame_t parsed;
+    parse_result_t result = PARSE_INCOMPLETE;
+
+    // AA AA 55 ...
+    result = command_parser_process_byte(&parser, FRAME_HEADER1);
+    for (uint16_t i = 0; i < len; i++) {
+        result = command_parser_process_byte(&parser, frame[i]);
+    }
+    assert(result == PARSE_SUCCESS);
+    assert(command_parser_get_frame(&parser, &parsed));
+
+    // 长度低字节出错，后面完整的帧被当作数据收下，校验出错时从缓存中找回
+    uint8_t bad[] = {FRAME_HEADER1, FRAME_HEADER2, CMD_VERIFY, 20, 0x00};
+    for (uint16_t i = 0; i < sizeof(bad); i++) {
+        command_parser_process_byte(&parser, bad[i]);
+    }
+    bool found = false;
+    for (uint16_t i = 0; i < len; i++) {
+        result = command_parser_process_byte(&parser, frame[i]);
+        assert(result != PARSE_SUCCESS || i == len - 1);
+    }
+    // 20字节数据+1字节校验还没有收满，补齐后校验失败并找回帧
+    for (uint16_t i = len; i < 20 + 1 && !found; i++) {
+        result = command_parser_process_byte(&parser, 0x00);
+        found = (result == PARSE_SUCCESS);
+    }
+    assert(found);
+    assert(command_parser_get_frame(&parser, &parsed));
+    assert(parsed.command == CMD_UPLOAD);
+    assert(parsed.data_length == sizeof(data));
+    assert(memcmp(parsed.data, data, sizeof(data)) == 0);
+
+    // 校验错误的帧之后紧跟的帧照常解析
+    uint8_t corrupt[FRAME_SIZE];
+    memcpy(corrupt, frame, len);
+    corrupt[6] ^= 0x01;
+    for (uint16_t i = 0; i < len; i++) {
+        result = command_parser_process_byte(&parser, corrupt[i]);
+    }
+    assert(result == PARSE_ERROR_CHECKSUM);
+    for (uint16_t i = 0; i < len; i++) {
+        result = command_parser_process_byte(&parser, frame[i]);
+    }
+    assert(result == PARSE_SUCCESS);
+
+    // 非法命令字是帧头时不丢失后面的帧
+    command_parser_process_byte(&parser, FRAME_HEADER1);
+    command_parser_process_byte(&parser, FRAME_HEADER2);
+    result = command_parser_process_byte(&parser, FRAME_HEADER1);
+    assert(result == PARSE_ERROR_INVALID_CMD);
+    for (uint16_t i = 1; i < len; i++) {
+        result = command_parser_process_byte(&parser, frame[i]);
+    }
+    assert(result == PARSE_SUCCESS);
+
+    printf("Parse resync test passed!\n\n");
+}
+
+// 测试事件队列和帧槽
+void test_event_queue(void) {
+    printf("=== Test: Event Queue ===\n");
+
+    BootEvent_t event;
+    Boot_EventReset();
+    assert(!Boot_EventGet(&event));
+    assert(Boot_EventCount() == 0);
+
+    // 先进先出，多圈循环后序号仍然正确
+    for (uint16_t round = 0; round < 3 * BOOT_EVENT_QUEUE_SIZE; round++) {
+        assert(Boot_EventPost(BOOT_EVENT_KEY, (uint8_t)round, round));
+        assert(Boot_EventPost(BOOT_EVENT_TX_DONE, 0, 0));
+        assert(Boot_EventCount() == 2);
+        assert(Boot_EventGet(&event));
+        assert(event.type == BOOT_EVENT_KEY);
+        assert(event.arg == (uint8_t)round && event.param == round);
+        assert(Boot_EventGet(&event));
+        assert(event.type == BOOT_EVENT_TX_DONE);
+    }
+
+    // 队列满时投递失败并计数，已有事件不被覆盖
+    for (uint16_t i = 0; i < BOOT_EVENT_QUEUE_SIZE; i++) {
+        assert(Boot_EventPost(BOOT_EVENT_PARSE_ERROR, (uint8_t)i, 0));
+    }
+    assert(!Boot_EventPost(BOOT_EVENT_TIMEOUT, 0, 0));
+    assert(Boot_EventDropped() == 1);
+    for (uint16_t i = 0; i < BOOT_EVENT_QUEUE_SIZE; i++) {
+        assert(Boot_EventGet(&event));
+        assert(event.type == BOOT_EVENT_PARSE_ERROR && event.arg == i);
+    }
+    assert(!Boot_EventGet(&event));
+
+    // 帧槽处理完之前不会被再次分配
+    uint8_t slots[BOOT_FRAME_SLOT_NUMS];
+    for (uint8_t i = 0; i < BOOT_FRAME_SLOT_NUMS; i++) {
+        command_frame_t *frame = Boot_FrameAlloc(&slots[i]);
+        assert(frame != NULL);
+        assert(Boot_FrameGet(slots[i]) == frame);
+        frame->command = CMD_UPLOAD;
+        frame->data_length = i;
+    }
+    uint8_t extra;
+    assert(Boot_FrameAlloc(&extra) == NULL);
+    assert(Boot_FrameGet(slots[0])->data_length == 0);
+    Boot_FrameRelease(slots[0]);
+    assert(Boot_FrameAlloc(&extra) != NULL);
+    assert(extra == slots[0]);
+
+    printf("Event queue test passed!\n\n");
+}
+
+// 测试任务：模拟分步擦除，忙时等待，推进后让出
+static int task_steps = 0;
+static bool task_busy = false;
+static int task_finished = 0;
+
+static BootTaskStatus_t test_step_task(BootTask_t *task) {
+    BOOT_TASK_BEGIN(task);
+    task_steps = 0;
+    while (task_steps < 3 && !BOOT_TASK_ABORTED(task)) {
+        task_steps++;
+        task_busy = true;
+        BOOT_TASK_WAIT_UNTIL(task, !task_busy);
+        BOOT_TASK_YIELD(task);
+    }
+    task_finished++;
+    BOOT_TASK_END(task);
+}
+
+void test_task_scheduler(void) {
+    printf("=== Test: Task Scheduler ===\n");
+
+    BootTask_t task;
+    Boot_TaskInit(&task, "step", test_step_task);
+    assert(!Boot_TaskIsRunning(&task));
+    assert(Boot_TaskStart(&task));
+    assert(Boot_TaskIsRunning(&task));
+
+    // 第一步启动后等待硬件，不需要立即再调度
+    assert(!Boot_TaskRunAll());
+    assert(task_steps == 1);
+    assert(!Boot_TaskRunAll());
+    assert(task_steps == 1);
+    // 硬件完成后继续，推进一步后让出
+    task_busy = false;
+    assert(Boot_TaskRunAll());
+    assert(!Boot_TaskRunAll());
+    assert(task_steps == 2);
+
+    // 中止后在下一个检查点收尾退出
+    Boot_TaskAbort(&task);
+    task_busy = false;
+    assert(Boot_TaskRunAll());
+    assert(!Boot_TaskRunAll());
+    assert(!Boot_TaskIsRunning(&task));
+    assert(task_finished == 1 && task_steps == 2);
+
+    // 重新启动从头执行，跑完后移出调度
+    assert(Boot_TaskStart(&task));
+    for (int i = 0; i < 3; i++) {
+        Boot_TaskRunAll();
+        task_busy = false;
+        Boot_TaskRunAll();
+    }
+    Boot_TaskRunAll();
+    assert(!Boot_TaskIsRunning(&task));
+    assert(task_finished == 2 && task_steps == 3);
+
+    printf("Task scheduler test passed!\n\n");
+}
+
+// 测试发送缓冲池
+void test_tx_pool(void) {
+    printf("=== Test: TX Pool ===\n");
+
+    Boot_EventReset();
+    uint8_t *small[BOOT_TX_SMALL_NUMS];
+    for (uint8_t i = 0; i < BOOT_TX_SMALL_NUMS; i++) {
+        small[i] = Boot_TxBufAlloc(FRAME_SIZE - FRAME_DATA_SIZE);
+        assert(small[i] != NULL);
+    }
+    assert(Boot_TxBufInUse() == BOOT_TX_SMALL_NUMS);
+
+    // 小缓冲用完时短应答借用大缓冲，大缓冲也用完后申请失败
+    uint8_t *large = Boot_TxBufAlloc(16);
+    assert(large != NULL);
+    memset(large, 0xA5, FRAME_SIZE);
+    assert(Boot_TxBufAlloc(16) == NULL);
+    assert(Boot_TxBufAlloc(FRAME_SIZE) == NULL);
+    assert(Boot_TxBufAlloc(FRAME_SIZE + 1) == NULL);
+
+    // 释放后同一个缓冲可以再次申请，非池中的地址忽略
+    Boot_TxBufRelease(large);
+    uint8_t other[4];
+    Boot_TxBufRelease(other);
+    assert(Boot_TxBufInUse() == BOOT_TX_SMALL_NUMS);
+    assert(Boot_TxBufAlloc(FRAME_SIZE) == large);
+    Boot_TxBufRelease(small[1]);
+    assert(Boot_TxBufAlloc(BOOT_TX_SMALL_SIZE) == small[1]);
+    // 小缓冲放不下的只能用大缓冲
+    Boot_TxBufRelease(small[2]);
+    assert(Boot_TxBufAlloc(BOOT_TX_SMALL_SIZE + 1) == NULL);
+
+    Boot_EventReset();
+    assert(Boot_TxBufInUse() == 0);
+
+    printf("TX pool test passed!\n\n");
+}
+
+// 测试续传进度：缺失范围、包大小不同时不能续传、存储内容损坏时清空
+void test_upload_resume(void) {
+    printf("=== Test: Upload Resume ===\n");
+
+    static BootResumeState_t state;
+    BootResumeRange_t ranges[3];
+    memset(&state, 0xA5, sizeof(state));
+    Boot_ResumeInit(&state);
+    assert(Boot_ResumeSession(512) == 0);
+    assert(Boot_ResumeGetMissing(ranges, 3) == 0);
+    assert(!Boot_ResumeMark(0));
+
+    Boot_ResumeStart(0x1234, 512, 100);
+    assert(Boot_ResumeSession(512) == 0x1234);
+    assert(Boot_ResumeSession(256) == 0);
+    assert(Boot_ResumeTotal() == 100);
+    assert(Boot_ResumeGetMissing(ranges, 3) == 1);
+    assert(ranges[0].first == 0 && ranges[0].count == 100);
+
+    // 写入0~39和50，重复记录不重复计数，超出总包数的包号拒绝
+    for (uint32_t i = 0; i < 40; i++) {
+        assert(Boot_ResumeMark(i));
+    }
+    assert(Boot_ResumeMark(50));
+    assert(Boot_ResumeMark(50));
+    assert(!Boot_ResumeMark(100));
+    assert(Boot_ResumeDoneCount() == 41);
+    assert(Boot_ResumeIsDone(31) && Boot_ResumeIsDone(32));
+    assert(!Boot_ResumeIsDone(40));
+    assert(Boot_ResumeGetMissing(ranges, 3) == 2);
+    assert(ranges[0].first == 40 && ranges[0].count == 10);
+    assert(ranges[1].first == 51 && ranges[1].count == 49);
+    // 输出个数受限时只列出前几段
+    assert(Boot_ResumeGetMissing(ranges, 1) == 1);
+    assert(ranges[0].first == 40);
+
+    // 重新绑定（模拟复位后从备份SRAM恢复）进度不变
+    Boot_ResumeInit(&state);
+    assert(Boot_ResumeSession(512) == 0x1234);
+    assert(Boot_ResumeDoneCount() == 41);
+    assert(Boot_ResumeImageLength() == 0);
+    for (uint32_t i = 40; i < 100; i++) {
+        Boot_ResumeMark(i);
+    }
+    assert(Boot_ResumeGetMissing(ranges, 3) == 0);
+    assert(Boot_ResumeImageLength() == 100 * 512);
+
+    // 头部被改写后校验不通过，进度清空
+    state.packetTotalNum = 99;
+    Boot_ResumeInit(&state);
+    assert(Boot_ResumeSession(512) == 0);
+    assert(Boot_ResumeDoneCount() == 0);
+
+    Boot_ResumeStart(0x5678, 512, 10);
+    Boot_ResumeClear();
+    assert(Boot_ResumeSession(512) == 0);
+
+    printf("Upload resume test passed!\n\n");
+}
+
+// 模拟一次升级：作废候选槽、写入完成、切换启动槽，每次修改后提交一次
+static BootSlot_t test_slot_update(BootSlotMeta_t *meta, uint32_t version) {
+    BootSlot_t slot = Boot_SlotMetaCandidate();
+    Boot_SlotMetaInvalidate(meta, slot);
+    meta->sequence++;
+    Boot_SlotMetaFinish(meta, slot, version, 0x1000, 0xC0DE0000 | version);
+    meta->sequence++;
+    assert(Boot_SlotMetaActivate(meta, slot));
+    meta->sequence++;
+    return slot;
+}
+
+// 测试连续两次升级：候选槽始终为B槽，A槽出厂固件保持不变，可随时回滚
+void test_slot_updates(void) {
+    printf("=== Test: Slot Updates ===\n");
+
+    BootSlotMeta_t meta;
+    BootSlotInfo_t factory;
+    Boot_SlotMetaDefault(&meta);
+    factory = meta.slot[BOOT_SLOT_A];
+    assert(meta.activeSlot == BOOT_SLOT_A);
+
+    // 第一次升级，app确认后B槽为当前槽
+    assert(test_slot_update(&meta, 1) == BOOT_SLOT_B);
+    assert(meta.activeSlot == BOOT_SLOT_B);
+    assert(!meta.slot[BOOT_SLOT_B].confirmed);
+    assert(Boot_SlotMetaConfirm(&meta));
+    assert(!Boot_SlotMetaConfirm(&meta));
+    uint32_t generation = meta.slot[BOOT_SLOT_B].generation;
+
+    // 第二次升级仍写B槽，不写已编程的A槽
+    assert(Boot_SlotMetaCandidate() == BOOT_SLOT_B);
+    Boot_SlotMetaInvalidate(&meta, BOOT_SLOT_B);
+    // 写入中途失败：当前槽已作废，只能回滚到A槽
+    assert(!Boot_SlotMetaActivate(&meta, BOOT_SLOT_B));
+    assert(Boot_SlotMetaRollback(&meta));
+    assert(meta.activeSlot == BOOT_SLOT_A);
+    assert(!Boot_SlotMetaRollback(&meta));
+
+    assert(test_slot_update(&meta, 2) == BOOT_SLOT_B);
+    assert(meta.activeSlot == BOOT_SLOT_B);
+    assert(meta.slot[BOOT_SLOT_B].version == 2);
+    assert(meta.slot[BOOT_SLOT_B].generation > generation);
+    assert(meta.slot[BOOT_SLOT_B].verifiedToken ==
+           Boot_SlotMetaToken(0xC0DE0002, meta.slot[BOOT_SLOT_B].generation));
+    assert(memcmp(&meta.slot[BOOT_SLOT_A], &factory, sizeof(factory)) == 0);
+
+    // 新固件未确认时回滚到出厂固件
+    assert(Boot_SlotMetaRollback(&meta));
+    assert(meta.activeSlot == BOOT_SLOT_A);
+    assert(Boot_SlotMetaCandidate() == BOOT_SLOT_B);
+
+    printf("Slot updates test passed!\n\n");
+}
+
+// 模拟flash：编程只能把1写成0，记录每个闪存字的编程次数
+#define TEST_FLASH_WORDS 4
+static uint8_t test_flash[TEST_FLASH_WORDS * BOOT_FLASH_WORD_SIZE];
+static int test_flash_programs[TEST_FLASH_WORDS];
+
+// 与boot.c的Boot_CombineFlush相同：读回原内容合并后再编程
+static BootErrorCode_t test_combine_flush(BootCombine_t *combine,
+                                          bool reprogram) {
+    uint8_t *flash = &test_flash[combine->offset];
+    bool program = false;
+    BootErrorCode_t err =
+        Boot_CombineMerge(combine, flash, reprogram, &program);
+    if (err == ERROR_CODE_NO_ERROR && program) {
+        for (uint32_t i = 0; i < BOOT_FLASH_WORD_SIZE; i++) {
+            flash[i] &= combine->word[i];
+        }
+        test_flash_programs[combine->offset / BOOT_FLASH_WORD_SIZE]++;
+    }
+    Boot_CombineReset(combine);
+    return err;
+}
+
+// 测试写合并：写出过一部分的闪存字再续写时保留已写入的数据
+void test_write_combine(void) {
+    printf("=== Test: Write Combine ===\n");
+
+    BootCombine_t combine;
+    uint8_t data[BOOT_FLASH_WORD_SIZE * 2];
+    bool program;
+    for (uint32_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)(i + 1);
+    }
+    memset(test_flash, 0xFF, sizeof(test_flash));
+    memset(test_flash_programs, 0, sizeof(test_flash_programs));
+    Boot_CombineReset(&combine);
+    assert(!Boot_CombinePending(&combine));
+
+    // 前10字节暂存，不在同一个闪存字的数据和重叠的数据不接收
+    assert(Boot_CombinePut(&combine, 0, data, 10) == 10);
+    assert(Boot_CombinePending(&combine) && !Boot_CombineFull(&combine));
+    assert(Boot_CombinePut(&combine, BOOT_FLASH_WORD_SIZE, data, 4) == 0);
+    assert(Boot_CombinePut(&combine, 8, data + 8, 4) == 0);
+    assert(Boot_CombineLength(&combine) == 10);
+
+    // 中途写出（如CMD_VERIFY），未填的字节保持0xFF
+    assert(test_combine_flush(&combine, true) == ERROR_CODE_NO_ERROR);
+    assert(test_flash_programs[0] == 1);
+    assert(memcmp(test_flash, data, 10) == 0 && test_flash[10] == 0xFF);
+
+    // 续写同一个闪存字，只接收到闪存字结尾的部分
+    assert(Boot_CombinePut(&combine, 10, data + 10, sizeof(data) - 10) ==
+           BOOT_FLASH_WORD_SIZE - 10);
+    assert(!Boot_CombineFull(&combine));
+    // 片内flash带ECC，已编程的闪存字不能再次编程
+    program = true;
+    assert(Boot_CombineMerge(&combine, test_flash, false, &program) ==
+           ERROR_CODE_FIRMWARE_INVALID_DATA);
+    // NOR flash合并原内容后再编程，前10字节不被0xFF覆盖
+    assert(test_combine_flush(&combine, true) == ERROR_CODE_NO_ERROR);
+    assert(test_flash_programs[0] == 2);
+    assert(memcmp(test_flash, data, BOOT_FLASH_WORD_SIZE) == 0);
+
+    // 重发相同数据不再编程，内容不同时拒绝
+    assert(Boot_CombinePut(&combine, 4, data + 4, 8) == 8);
+    assert(test_combine_flush(&combine, false) == ERROR_CODE_NO_ERROR);
+    assert(test_flash_programs[0] == 2);
+    assert(Boot_CombinePut(&combine, 4, data, 8) == 8);
+    assert(test_combine_flush(&combine, true) ==
+           ERROR_CODE_FIRMWARE_INVALID_DATA);
+    assert(memcmp(test_flash, data, BOOT_FLASH_WORD_SIZE) == 0);
+
+    // 凑满整个闪存字
+    assert(Boot_CombinePut(&combine, BOOT_FLASH_WORD_SIZE, data, 5) == 5);
+    assert(Boot_CombinePut(&combine, BOOT_FLASH_WORD_SIZE + 5, data + 5,
+                           sizeof(data)) == BOOT_FLASH_WORD_SIZE - 5);
+    assert(Boot_CombineFull(&combine));
+    assert(test_combine_flush(&combine, false) == ERROR_CODE_NO_ERROR);
+    assert(test_flash_programs[1] == 1);
+    assert(memcmp(&test_flash[BOOT_FLASH_WORD_SIZE], data,
+                  BOOT_FLASH_WORD_SIZE) == 0);
+
+    printf("Write combine test passed!\n\n");
+}
+
+// 与boot.c的Boot_BlockCRCTask相同：暂存的闪存字按写出后的内容计算
+static uint32_t test_block_crc(const BootCombine_t *combine) {
+    uint8_t block[sizeof(test_flash)];
+    memcpy(block, test_flash, sizeof(block));
+    if (Boot_CombinePending(combine)) {
+        Boot_CombineView(combine, &block[combine->offset]);
+    }
+    return command_calc_check(FRAME_CHECK_CRC32, block, sizeof(block));
+}
+
+// 测试按地址上传中途查询块CRC：暂存的闪存字不写出，下一条记录接着填
+void test_block_crc_pending(void) {
+    printf("=== Test: Block CRC With Pending Word ===\n");
+
+    BootCombine_t combine;
+    uint8_t image[sizeof(test_flash)];
+    uint32_t crc;
+    memset(test_flash, 0xFF, sizeof(test_flash));
+    memset(test_flash_programs, 0, sizeof(test_flash_programs));
+    memset(image, 0xFF, sizeof(image));
+    for (uint32_t i = 0; i < 50; i++) {
+        image[i] = (uint8_t)(0x80 + i);
+    }
+    Boot_CombineReset(&combine);
+
+    // 第一条记录写到第一个闪存字中间
+    assert(Boot_CombinePut(&combine, 0, image, 10) == 10);
+    // CMD_BLOCK_CRC：结果包含暂存的数据，flash不变
+    crc = test_block_crc(&combine);
+    assert(test_flash_programs[0] == 0);
+    assert(test_flash[0] == 0xFF);
+    memset(image + 10, 0xFF, 40);
+    assert(crc == command_calc_check(FRAME_CHECK_CRC32, image, sizeof(image)));
+    for (uint32_t i = 10; i < 50; i++) {
+        image[i] = (uint8_t)(0x80 + i);
+    }
+
+    // 第二条记录接着填同一个闪存字，凑满后只编程一次
+    assert(Boot_CombinePut(&combine, 10, image + 10, 40) ==
+           BOOT_FLASH_WORD_SIZE - 10);
+    assert(Boot_CombineFull(&combine));
+    assert(test_combine_flush(&combine, false) == ERROR_CODE_NO_ERROR);
+    assert(Boot_CombinePut(&combine, BOOT_FLASH_WORD_SIZE,
+                           image + BOOT_FLASH_WORD_SIZE,
+                           50 - BOOT_FLASH_WORD_SIZE) ==
+           50 - BOOT_FLASH_WORD_SIZE);
+    assert(test_block_crc(&combine) ==
+           command_calc_check(FRAME_CHECK_CRC32, image, sizeof(image)));
+    assert(test_combine_flush(&combine, false) == ERROR_CODE_NO_ERROR);
+    assert(test_flash_programs[0] == 1 && test_flash_programs[1] == 1);
+    assert(memcmp(test_flash, image, sizeof(image)) == 0);
+    assert(test_block_crc(&combine) ==
+           command_calc_check(FRAME_CHECK_CRC32, image, sizeof(image)));
+
+    printf("Block CRC with pending word test passed!\n\n");
+}